@@ -9,12 +9,15 @@
 #include "posix/errno.h"
 #include "printk.h"
 
+#define UART_POLL_US    1000    // RX poll period while a read waits in polling mode
+
 typedef struct uart_state {
     cmd_line_t uart_cmd;
     char line_buf[BUFLEN];
     volatile int line_ready;
     volatile int line_len;
     int irq_enabled;
+    uint32_t poll_timer;
     noza_msg_t pending_read_msg;
     console_msg_t *pending_read_cmsg;
 } uart_state_t;
@@ -62,6 +65,9 @@ static void reply_pending_line_if_ready(uart_state_t *state)
     state->pending_read_msg.ptr = NULL;
     state->line_ready = 0;
     state->line_len = 0;
+    if (!state->irq_enabled) {
+        noza_timer_cancel(state->poll_timer);
+    }
 }
 
 int uart_service_start(void *param, uint32_t pid)
@@ -84,10 +90,44 @@ int uart_service_start(void *param, uint32_t pid)
 
     // UART RX IRQ temporarily disabled; use polling mode.
     uart_state.irq_enabled = 0;
+    // a parked read is served from a periodic poll, without blocking other requests
+    // without the timer only the port is watched, and a timed-out wait stands in for the fire
+    uint32_t source_count = 2;
+    int32_t wait_us = -1;
+    if (noza_timer_create(&uart_state.poll_timer) != 0) {
+        printk("console.io: poll timer create failed, polling on receive timeouts\n");
+        source_count = 1;
+        wait_us = UART_POLL_US;
+    }
+    noza_wait_source_t sources[] = {
+        { .type = NOZA_WAIT_PORT },
+        { .type = NOZA_WAIT_TIMER, .id = uart_state.poll_timer },
+    };
 
     noza_msg_t msg;
+    noza_msg_t *reply = NULL; // answered by the next noza_reply_recv
     for (;;) {
-        if (noza_recv(&msg) != 0) {
+        if (!uart_state.irq_enabled && uart_state.pending_read_cmsg != NULL) {
+            if (reply != NULL) {
+                noza_reply(reply);
+                reply = NULL;
+            }
+            int wait_ret = noza_wait_any(sources, source_count, wait_us);
+            if (wait_ret == ETIMEDOUT || (wait_ret == 0 && source_count > 1 && sources[1].ready)) {
+                if (wait_ret == 0) {
+                    noza_timer_wait(uart_state.poll_timer, 0); // take the fire
+                }
+                handle_irq_input(&uart_state);
+                reply_pending_line_if_ready(&uart_state);
+            }
+            if (wait_ret == ETIMEDOUT || (wait_ret == 0 && !sources[0].ready)) {
+                continue;
+            }
+            // a request is queued, or the wait failed: take the blocking receive rather than spin
+        }
+        int ret = noza_reply_recv(reply, &msg);
+        reply = NULL;
+        if (ret != 0) {
             continue;
         }
         if (msg.ptr && msg.size == sizeof(noza_irq_event_t)) {
@@ -109,7 +149,7 @@ int uart_service_start(void *param, uint32_t pid)
                         driver.putc(cmsg->buf[i]);
                     }
                     cmsg->code = 0;
-                    noza_reply(&msg);
+                    reply = &msg;
                     break;
                 }
                 case CONSOLE_CMD_READLINE: {
@@ -121,30 +161,13 @@ int uart_service_start(void *param, uint32_t pid)
                         cmsg->code = 0;
                         uart_state.line_ready = 0;
                         uart_state.line_len = 0;
-                        noza_reply(&msg);
-                        break;
-                    }
-
-                    if (!uart_state.irq_enabled) {
-                        uart_state.line_ready = 0;
-                        uart_state.line_len = 0;
-                        while (!uart_state.line_ready) {
-                            handle_irq_input(&uart_state);
-                            noza_thread_sleep_ms(1, NULL);
-                        }
-                        uint32_t copy_len = ((uint32_t)uart_state.line_len < cmsg->len) ? (uint32_t)uart_state.line_len : cmsg->len;
-                        memcpy(cmsg->buf, uart_state.line_buf, copy_len);
-                        cmsg->len = copy_len;
-                        cmsg->code = 0;
-                        uart_state.line_ready = 0;
-                        uart_state.line_len = 0;
-                        noza_reply(&msg);
+                        reply = &msg;
                         break;
                     }
 
                     if (uart_state.pending_read_cmsg != NULL) {
                         cmsg->code = EBUSY;
-                        noza_reply(&msg);
+                        reply = &msg;
                         break;
                     }
 
@@ -152,17 +175,20 @@ int uart_service_start(void *param, uint32_t pid)
                     uart_state.line_len = 0;
                     uart_state.pending_read_msg = msg;
                     uart_state.pending_read_cmsg = cmsg;
+                    if (!uart_state.irq_enabled) {
+                        noza_timer_arm(uart_state.poll_timer, UART_POLL_US, NOZA_TIMER_FLAG_PERIODIC);
+                    }
                     // prompt is handled by callers via console_write; no reply until line arrives
                     break;
                 }
                 default:
                     cmsg->code = 1;
-                    noza_reply(&msg);
+                    reply = &msg;
                     break;
             }
             continue;
         }
-        noza_reply(&msg);
+        reply = &msg;
     }
     return 0;
 }
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+// extended futex operations, issued through NSC_FUTEX_OP with a noza_futex_op_t block
+#define NOZA_FUTEX_WAIT_BITSET      0   // addr, val = expected, val3 = bitset, timeout_us
+#define NOZA_FUTEX_WAKE_BITSET      1   // addr, val = count, val3 = bitset
+#define NOZA_FUTEX_REQUEUE          2   // addr, val = wake count, addr2, val2 = requeue count
+#define NOZA_FUTEX_CMP_REQUEUE      3   // as REQUEUE, EAGAIN unless *addr == val3
+#define NOZA_FUTEX_WAKE_OP          4   // addr, val = wake count, addr2, val2 = wake count, val3 = encoded op
+#define NOZA_FUTEX_LOCK_PI          5   // addr, timeout_us
+#define NOZA_FUTEX_TRYLOCK_PI       6   // addr
+#define NOZA_FUTEX_UNLOCK_PI        7   // addr
+
+#define NOZA_FUTEX_BITSET_ANY       0xFFFFFFFFu
+
+// priority-inheritance futex word: 0 when free, otherwise the owner's vid plus one
+// (vid 0 is a valid thread) and NOZA_FUTEX_PI_WAITERS while threads are blocked on it
+#define NOZA_FUTEX_PI_WAITERS       0x80000000u
+#define NOZA_FUTEX_PI_OWNER_MASK    0x3FFFFFFFu
+#define NOZA_FUTEX_PI_WORD(vid)     (((uint32_t)(vid) + 1) & NOZA_FUTEX_PI_OWNER_MASK)
+#define NOZA_FUTEX_PI_OWNER(word)   (((word) & NOZA_FUTEX_PI_OWNER_MASK) - 1)
+
+// NOZA_FUTEX_WAKE_OP: old = *addr2; *addr2 = old OP oparg; wake addr; if (old CMP cmparg) wake addr2
+// the read-modify-write of addr2 is atomic against __atomic_* updates from user space
+#define NOZA_FUTEX_OP_SET           0   // *addr2 = oparg
+#define NOZA_FUTEX_OP_ADD           1   // *addr2 += oparg
+#define NOZA_FUTEX_OP_OR            2   // *addr2 |= oparg
+#define NOZA_FUTEX_OP_ANDN          3   // *addr2 &= ~oparg
+#define NOZA_FUTEX_OP_XOR           4   // *addr2 ^= oparg
+#define NOZA_FUTEX_OP_OPARG_SHIFT   8   // use (1 << oparg) as the operand
+
+#define NOZA_FUTEX_OP_CMP_EQ        0
+#define NOZA_FUTEX_OP_CMP_NE        1
+#define NOZA_FUTEX_OP_CMP_LT        2
+#define NOZA_FUTEX_OP_CMP_LE        3
+#define NOZA_FUTEX_OP_CMP_GT        4
+#define NOZA_FUTEX_OP_CMP_GE        5
+
+// oparg and cmparg are signed 12-bit values
+#define NOZA_FUTEX_OP(op, oparg, cmp, cmparg) \
+    ((((uint32_t)(op) & 0xf) << 28) | (((uint32_t)(cmp) & 0xf) << 24) | \
+     (((uint32_t)(oparg) & 0xfff) << 12) | ((uint32_t)(cmparg) & 0xfff))
+
+typedef struct {
+    uint32_t    op;
+    uint32_t    *addr;
+    uint32_t    val;
+    uint32_t    val2;
+    uint32_t    *addr2;
+    uint32_t    val3;
+    int32_t     timeout_us;     // NOZA_FUTEX_WAIT_BITSET and LOCK_PI, negative waits forever
+} noza_futex_op_t;
@@ -8,13 +8,43 @@ typedef struct {
     uint32_t umask;
 } noza_identity_t;
 
+// a message with size NOZA_MSG_SHORT carries its payload in word[] instead of ptr; the
+// words travel in r4-r7 through the trap, so neither side dereferences the other's memory
+#define NOZA_MSG_SHORT          0xFFFFFFFFu
+#define NOZA_MSG_SHORT_WORDS    4
+
 typedef struct {
     uint32_t to_vid;
     void *ptr;
     uint32_t size;
+    uint32_t word[NOZA_MSG_SHORT_WORDS]; // keep right after size, the syscall stubs load r1-r7 in one go
     noza_identity_t identity;
 } noza_msg_t;
 
+// ids of kernel port objects (noza_port_create) have these top bits, thread vids never do;
+// a port id is accepted wherever a call names its target vid
+#define NOZA_PORT_ID_FLAG           0x40000000u
+#define NOZA_PORT_IS_ID(id)         (((id) & 0xC0000000u) == NOZA_PORT_ID_FLAG)
+
+// a server receiving an async request (noza_call_async) sees this kind of id as the sender
+// and replies to it as usual; the reply becomes a completion of the sending thread
+#define NOZA_ASYNC_ID_FLAG          0x80000000u
+#define NOZA_ASYNC_IS_ID(id)        (((id) & 0xC0000000u) == NOZA_ASYNC_ID_FLAG)
+
+// port flags, set by a server with noza_port_set_flags()
+#define NOZA_PORT_PRIORITY_DONATION 0x01    // run at the priority of the most urgent caller until replied
+#define NOZA_PORT_FLAGS_ALL         0x01
+
+// noza_call_batch() sends at most this many messages in one trap
+#define NOZA_CALL_BATCH_MAX         16
+
+// completion of an async request, collected with noza_async_wait()
+typedef struct {
+    uint32_t    tag;        // as passed to noza_call_async
+    int32_t     status;     // 0 when replied, otherwise why the request failed
+    noza_msg_t  reply;      // the reply, as noza_call leaves it in its message
+} noza_async_result_t;
+
 #define NOZA_DEFAULT_UID    0
 #define NOZA_DEFAULT_GID    0
 #define NOZA_DEFAULT_UMASK  0022u
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include "platform_config.h"
+
+// Kernel data page: written only by the kernel, read by libc without a trap.
+// Each core owns one slot and rewrites it on every switch to a thread, bracketed
+// by its sequence counter (odd while the write is in progress), so a reader that
+// sees the same even sequence before and after its reads got a consistent copy.
+//
+// monotonic us = base_us + (((uint32_t)(count - base_count) * clock_mult) >> clock_shift)
+// where count is platform_get_clock_count(), a free-running counter at clock_hz.
+
+#define NOZA_KDATA_VERSION      1
+#define NOZA_KDATA_CLOCK_SHIFT  24
+#define NOZA_KDATA_REFRESH_US   1000000     // a running core rewrites its slot at least this often
+
+typedef struct {
+    volatile uint32_t   seq;
+    volatile uint32_t   vid;            // thread running on the core, 0 before the first switch
+    volatile uint32_t   base_count;
+    volatile int64_t    base_us;
+} noza_kdata_core_t;
+
+typedef struct {
+    uint32_t            version;        // NOZA_KDATA_VERSION once the page is filled in
+    uint32_t            num_cores;
+    uint32_t            clock_hz;
+    uint32_t            clock_mult;
+    uint32_t            clock_shift;
+    int64_t             realtime_offset_us;
+    noza_kdata_core_t   core[NOZA_OS_NUM_CORES];
+} noza_kdata_t;
+
+extern noza_kdata_t noza_kdata;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+// deadline scheduling class: the thread may run for runtime_us in every period_us and
+// must get it within deadline_us of the period start (runtime <= deadline <= period).
+// Admitted threads run ahead of every fixed priority, earliest deadline first; a
+// thread that used up its runtime waits for the next period.
+typedef struct {
+    uint32_t    runtime_us;
+    uint32_t    deadline_us;
+    uint32_t    period_us;
+} noza_sched_deadline_t;
+
+// thread states reported by noza_thread_stats (same numbering as the kernel's)
+#define NOZA_THREAD_STATE_FREE          0
+#define NOZA_THREAD_STATE_RUNNING       1
+#define NOZA_THREAD_STATE_READY         2
+#define NOZA_THREAD_STATE_WAITING_MSG   3
+#define NOZA_THREAD_STATE_WAITING_READ  4
+#define NOZA_THREAD_STATE_WAITING_REPLY 5
+#define NOZA_THREAD_STATE_WAITING_SYNC  6
+#define NOZA_THREAD_STATE_SLEEP         7
+#define NOZA_THREAD_STATE_ZOMBIE        8
+#define NOZA_THREAD_STATE_PENDING_JOIN  9
+#define NOZA_THREAD_STATE_STOPPED       10
+#define NOZA_THREAD_STATE_THROTTLED     11
+
+// per-thread CPU accounting, one record per live thread. A switch is voluntary when
+// the thread blocked or yielded in a system call, involuntary when it was preempted.
+typedef struct {
+    uint32_t    vid;
+    uint8_t     state;                  // NOZA_THREAD_STATE_*
+    uint8_t     priority;
+    uint8_t     last_core;              // core the thread last ran on
+    uint8_t     reserved;
+    uint64_t    run_us;                 // total time on a core
+    uint32_t    voluntary_switches;
+    uint32_t    involuntary_switches;
+    uint32_t    syscalls;
+} noza_thread_stat_t;
+
+// kernel spin lock counters, one record per lock: the ipc, timer and sched domains,
+// every futex stripe and the futex entry pool
+#define NOZA_LOCK_NAME_LEN  12
+typedef struct {
+    char        name[NOZA_LOCK_NAME_LEN];
+    uint32_t    index;                  // stripe number of a futex stripe, 0 otherwise
+    uint32_t    acquired;               // outermost acquisitions
+    uint32_t    contended;              // acquisitions that found the lock held by another core
+} noza_lock_stat_t;
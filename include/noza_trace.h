@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+// Kernel event trace: every core appends fixed-size records to its own ring while
+// NOZA_OS_ENABLE_TRACE is set; noza_trace_read drains them (oldest first per core)
+// and /dev/trace exposes the same stream. scripts/noza_trace.py turns a dump into
+// Chrome trace JSON.
+
+#define NOZA_TRACE_SWITCH           1   // vid starts running on core, 0 when the core goes idle
+#define NOZA_TRACE_SYSCALL_ENTER    2   // arg = first argument (r1), extra = syscall number
+#define NOZA_TRACE_SYSCALL_EXIT     3   // arg = result (r0), extra = syscall number
+#define NOZA_TRACE_IPC_SEND         4   // arg = target id, extra = message size
+#define NOZA_TRACE_IPC_RECV         5   // vid = receiver, arg = sender id
+#define NOZA_TRACE_IPC_REPLY        6   // arg = client id
+#define NOZA_TRACE_FUTEX_WAIT       7   // arg = futex address
+#define NOZA_TRACE_FUTEX_WAKE       8   // vid = woken thread, arg = futex address
+#define NOZA_TRACE_TIMER_FIRE       9   // vid = timer owner, arg = timer id
+#define NOZA_TRACE_IRQ              10  // arg = irq id, recorded in the ISR
+#define NOZA_TRACE_LOST             11  // arg = records the core dropped while its ring was full
+
+typedef struct {
+    uint32_t    time_us;                // low 32 bits of the monotonic clock
+    uint32_t    vid;
+    uint32_t    arg;
+    uint16_t    extra;
+    uint8_t     event;                  // NOZA_TRACE_*
+    uint8_t     core;
+} noza_trace_record_t;                  // 16 bytes, the dump is an array of these
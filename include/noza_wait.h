@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+// sources watched by noza_wait_any(); a source is ready while its condition holds and
+// waiting consumes nothing, so follow up with the usual call (noza_recv, noza_timer_wait, ...)
+#define NOZA_WAIT_PORT          0   // id = 0 for the caller's own port, or a port id: a message is queued
+#define NOZA_WAIT_TIMER         1   // id = timer id: it fired and nobody waited for the fire yet
+#define NOZA_WAIT_FUTEX         2   // addr, val: *addr != val, looked at again when the kernel wakes or writes addr
+#define NOZA_WAIT_IRQ           3   // id = irq id: an event of the IRQ is queued for its owner
+#define NOZA_WAIT_ASYNC         4   // an async request of the caller completed (noza_async_wait)
+
+#define NOZA_WAIT_SOURCES_MAX   16
+
+typedef struct {
+    uint32_t    type;       // NOZA_WAIT_*
+    uint32_t    id;
+    uint32_t    *addr;      // NOZA_WAIT_FUTEX
+    uint32_t    val;        // NOZA_WAIT_FUTEX
+    uint32_t    ready;      // set by noza_wait_any, non-zero when the source is ready
+} noza_wait_source_t;
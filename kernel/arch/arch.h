@@ -3,12 +3,16 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define ARCH_TRAP_WORDS     4   // r4-r7, spilled to the thread stack on every trap
+
 typedef struct {
     uint32_t r0;
     uint32_t r1;
     uint32_t r2;
     uint32_t r3;
     uint32_t state;
+    uint32_t word[ARCH_TRAP_WORDS];  // short message payload handed back in r4-r7
+    uint32_t word_output;            // word[] is written back with the next arch_trap
 } kernel_trap_info_t;
 
 typedef struct {
@@ -24,6 +28,7 @@ typedef struct {
 uint32_t *arch_build_stack(uint32_t thread_id, uint32_t *stack, uint32_t size,
     void (*entry)(void *), void *param);
 void arch_trap(void *stack_ptr, kernel_trap_info_t *info);
+void arch_trap_get_words(void *stack_ptr, uint32_t *words);
 void arch_core_dump(void *stack_ptr, uint32_t pid);
 void arch_fault_capture(uint32_t *psp);
 bool arch_get_fault_snapshot(arch_fault_snapshot_t *out);
@@ -68,6 +68,24 @@ void arch_trap(void *_stack_ptr, kernel_trap_info_t *info)
     uint32_t *stack_ptr = (uint32_t *)_stack_ptr;
     interrupted_stack_t *is = (interrupted_stack_t *)(stack_ptr + (sizeof(user_stack_t)/sizeof(uint32_t)));
     memcpy(is, info, sizeof(uint32_t)*4);
+    if (info->word_output) {
+        user_stack_t *us = (user_stack_t *)stack_ptr;
+        us->r4 = info->word[0];
+        us->r5 = info->word[1];
+        us->r6 = info->word[2];
+        us->r7 = info->word[3];
+        info->word_output = 0;
+    }
+}
+
+// read r4-r7 of a trapped thread, the payload of a short message
+void arch_trap_get_words(void *_stack_ptr, uint32_t *words)
+{
+    user_stack_t *us = (user_stack_t *)_stack_ptr;
+    words[0] = us->r4;
+    words[1] = us->r5;
+    words[2] = us->r6;
+    words[3] = us->r7;
 }
 
 #if 0
@@ -2,11 +2,24 @@
 
 #include "platform_config.h"
 
-#define NOZA_OS_STACK_SIZE       192         // size of our user task stacks in words
-#define NOZA_OS_TASK_LIMIT       32          // number of user task
+#define NOZA_OS_STACK_SIZE       192         // size of the root task entry stack in words
+#define NOZA_OS_THREAD_STACK_SIZE 96          // default entry stack of a created thread in words
+#define NOZA_OS_THREAD_STACK_MIN  48          // smallest entry stack a create call may ask for, in words
+#define NOZA_OS_PROCESS_STACK_SIZE 192        // entry stack of a process main thread, its exit path tears down the process
+#define NOZA_OS_TASK_LIMIT       128         // max number of threads (size of the TCB index table)
+#define NOZA_KERNEL_ARENA_SIZE   (32 * 1024) // bytes shared by TCB slabs and thread entry stacks
 #define NOZA_OS_TIME_SLICE       10000       // scheduler timer, in us
-#define NOZA_OS_PRIORITY_LIMIT   8           // levels of priority
+#define NOZA_OS_PRIORITY_LIMIT   8           // levels of priority (max 32)
 #define NOZA_MAX_SERVICES        8           // number of services
+#define NOZA_MAX_TIMERS          32          // number of kernel timers
+#define NOZA_MAX_PORTS           8           // number of kernel port objects
+#define NOZA_MAX_ASYNC           16          // async IPC requests in flight, system wide
+#define NOZA_EDF_MAX_THREADS     8           // threads admitted to the deadline class
+#define NOZA_EDF_UTIL_LIMIT      90          // percent of a core the deadline class may reserve
+#ifndef NOZA_OS_ENABLE_TRACE
+#define NOZA_OS_ENABLE_TRACE     1           // record kernel events in the per-core trace rings
+#endif
+#define NOZA_TRACE_RING_SIZE     256         // trace records per core, power of two
 #define NOZA_MAX_PROCESSES      16           // number of processes
 #define NOZA_PROC_THREAD_COUNT  32           // number of threads per process
 #define NOZA_PROCESS_ENV_SIZE	256          // size of process environment buffer
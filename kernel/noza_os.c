@@ -1,4 +1,5 @@
 #include <string.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <inttypes.h>
@@ -10,6 +11,11 @@
 #include "syscall.h"
 #include "platform.h"
 #include "../include/noza_ipc.h"
+#include "../include/noza_futex.h"
+#include "../include/noza_wait.h"
+#include "../include/noza_kdata.h"
+#include "../include/noza_sched.h"
+#include "../include/noza_trace.h"
 #include "posix/bits/signum.h"
 #include "posix/errno.h"
 #if NOZA_OS_ENABLE_IRQ
@@ -39,6 +45,7 @@
 #define THREAD_ZOMBIE           8
 #define THREAD_PENDING_JOIN     9
 #define THREAD_STOPPED          10
+#define THREAD_THROTTLED        11          // deadline thread out of runtime until its next period
 
 #define SYSCALL_DONE            0
 #define SYSCALL_PENDING         1
@@ -54,19 +61,33 @@
 #define NOZA_INVALID_CORE       0xFF
 #define NOZA_CORE_ANY           (-1)
 #define NOZA_WAIT_FOREVER       ((int64_t)-1)
-#define NOZA_FUTEX_SLOT_COUNT   64
-#define NOZA_MAX_TIMERS         32
+#define NOZA_FUTEX_BUCKET_COUNT 64          // futex hash buckets, each chains the addresses with waiters
+#define NOZA_FUTEX_ENTRY_COUNT  NOZA_OS_TASK_LIMIT // per-address futex entries, one per address with waiters
+#define NOZA_FUTEX_LOCK_COUNT   8           // futex lock stripes, bucket i uses stripe i % count
+
+#if (NOZA_FUTEX_BUCKET_COUNT & (NOZA_FUTEX_BUCKET_COUNT - 1)) != 0 || \
+    (NOZA_FUTEX_BUCKET_COUNT % NOZA_FUTEX_LOCK_COUNT) != 0
+#error "NOZA_FUTEX_BUCKET_COUNT must be a power of two and a multiple of NOZA_FUTEX_LOCK_COUNT"
+#endif
 #define NOZA_VID_AUTO           0xFFFFFFFFu
 
-inline static uint8_t hash32to8(uint32_t value) {
-    uint8_t byte1 = (value >> 24) & 0xFF; // High byte
-    uint8_t byte2 = (value >> 16) & 0xFF; // Mid-high byte
-    uint8_t byte3 = (value >> 8) & 0xFF;  // Mid-low byte
-    uint8_t byte4 = value & 0xFF;         // Low byte
+#if NOZA_OS_PRIORITY_LIMIT > 32
+#error "NOZA_OS_PRIORITY_LIMIT must fit in the 32-bit ready bitmap"
+#endif
 
-    // XOR the chunks together
-    return byte1 ^ byte2 ^ byte3 ^ byte4;
-}
+// virtual id layout: (generation << NOZA_VID_INDEX_BITS) | TCB index
+// generation starts from 1, so an auto-assigned vid is never 0
+#define NOZA_VID_INDEX_BITS     10
+#define NOZA_VID_INDEX_MASK     ((1u << NOZA_VID_INDEX_BITS) - 1)
+#define NOZA_VID_GEN_LIMIT      0x10000u
+#define NOZA_VID_INVALID        0xFFFFFFFFu     // vid of a free TCB, never resolves
+#define NOZA_VID_ALIAS_LIMIT    NOZA_MAX_SERVICES
+
+#define NOZA_CORE_MASK_ALL      ((1u << NOZA_OS_NUM_CORES) - 1)  // thread affinity: any core
+
+#if NOZA_OS_TASK_LIMIT >= (1 << NOZA_VID_INDEX_BITS)
+#error "NOZA_OS_TASK_LIMIT does not fit in the vid index field"
+#endif
 
 inline static void HALT()
 {
@@ -119,7 +140,7 @@ void kernel_panic(const char *fmt, ...)
 // share area between kernel and user
 // kernel update the data, and user read only
 
-uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
+noza_kdata_t noza_kdata;
 
 const char *state_to_str(uint32_t id) 
 {
@@ -134,7 +155,8 @@ const char *state_to_str(uint32_t id)
         [THREAD_SLEEP] = "THREAD_SLEEP",
         [THREAD_ZOMBIE] = "THREAD_ZOMBIE",
         [THREAD_PENDING_JOIN] = "THREAD_PENDING_JOIN",
-        [THREAD_STOPPED] = "THREAD_STOPPED"
+        [THREAD_STOPPED] = "THREAD_STOPPED",
+        [THREAD_THROTTLED] = "THREAD_THROTTLED"
     };
     if (id < sizeof(state_str)/sizeof(char *)) {
         return state_str[id];
@@ -217,18 +239,58 @@ typedef struct {
 } thread_list_t;
 
 typedef struct thread_s thread_t;
+
+// queue of noza_async_t, oldest first
+typedef struct {
+    cdl_node_t  *head;
+    uint32_t    count;
+} noza_async_list_t;
+
 typedef struct {
     thread_list_t   reply_list;     // a list of threads waiting for reply
-    thread_list_t   pending_list;   // a list of threads waiting for this port
+    thread_list_t   pending_list;   // a list of threads waiting for this port, by priority
+    noza_async_list_t async_list;   // async requests waiting for this port
+    uint32_t        flags;          // NOZA_PORT_* set with NSC_PORT_SET_FLAGS
 } noza_os_port_t;
 
+// kernel spin lock: one per state domain, re-entrant on the owning core
+typedef struct {
+    volatile uint32_t   word;               // non-zero while claimed, see platform_spin_try_claim
+    volatile int32_t    owner;              // core holding the lock, -1 when free
+    uint32_t            depth;              // nested acquisitions by the owner
+    const char          *name;
+    uint32_t            acquired;           // outermost acquisitions
+    uint32_t            contended;          // acquisitions that found the lock busy
+} noza_klock_t;
+
 typedef struct noza_wait_queue_s {
     cdl_node_t      *head;
     uint32_t         count;
+    noza_klock_t    *lock;      // domain lock guarding the queue
+    bool             release;   // futex entry queue, handed back to the pool when it drains
 } noza_wait_queue_t;
 
+// deadline queue entry, embedded in every object that can expire
+#define NOZA_DEADLINE_TIMER     0           // noza_timer_t expiry
+#define NOZA_DEADLINE_SLEEP     1           // thread in noza_os.sleep
+#define NOZA_DEADLINE_SYNC      2           // thread waiting on a wait queue with a timeout
+#define NOZA_DEADLINE_EDF       3           // next period of a deadline-class thread
+#define NOZA_DEADLINE_IDLE      0xFFFFu     // entry is not in the queue
+#define NOZA_DEADLINE_CAPACITY  (NOZA_MAX_TIMERS + NOZA_OS_TASK_LIMIT + NOZA_EDF_MAX_THREADS)
+#define NOZA_DEADLINE_DEFER_MAX 8           // contended sync timeouts set aside in one expiry pass
+
+typedef struct {
+    int64_t     when;       // absolute expiry time in us
+    uint16_t    slot;       // index in the heap, NOZA_DEADLINE_IDLE if not queued
+    uint8_t     kind;       // NOZA_DEADLINE_TIMER, _SLEEP, _SYNC or _EDF
+    uint32_t    slack;      // us it may fire late to share a wakeup with a later event
+} noza_deadline_t;
+
+#define DEADLINE_OWNER(entry, type, member) \
+    ((type *)((char *)(entry) - offsetof(type, member)))
+
 typedef struct noza_timer_s {
-    cdl_node_t          node;
+    noza_deadline_t     event;
     noza_wait_queue_t   wait_queue;
     uint32_t            id;
     uint32_t            owner_vid;
@@ -238,15 +300,18 @@ typedef struct noza_timer_s {
     uint32_t            pending_fires;
     bool                in_use;
     bool                armed;
+    struct noza_timer_s *next_free;
 } noza_timer_t;
 
-static inline void noza_wait_queue_init(noza_wait_queue_t *queue);
+static inline void noza_wait_queue_init(noza_wait_queue_t *queue, noza_klock_t *lock);
 
-typedef struct {
-    uintptr_t           key;
-    bool                in_use;
-    noza_wait_queue_t   queue;
-} noza_futex_slot_t;
+// per-address futex entry: chained in its hash bucket while the address has waiters and
+// returned to the free pool when the queue drains, so a lookup only walks live addresses
+typedef struct noza_futex_entry_s {
+    noza_wait_queue_t           queue;      // first member, the queue pointer is the entry
+    uintptr_t                   key;        // futex address
+    struct noza_futex_entry_s   *next;      // bucket chain, or the free pool
+} noza_futex_entry_t;
 
 #if NOZA_OS_ENABLE_IRQ
 typedef struct {
@@ -257,10 +322,33 @@ typedef struct {
 } irq_binding_t;
 #endif
 
+// deadline scheduling class state; period 0 means the thread uses its fixed priority
+typedef struct {
+    noza_deadline_t     event;      // replenishment at the start of the next period
+    int64_t             period_start;
+    int64_t             deadline;   // absolute deadline of the current period, the EDF key
+    int32_t             remaining;  // runtime left in this period, in us
+    uint32_t            runtime;
+    uint32_t            rel_deadline;
+    uint32_t            period;
+    uint32_t            util;       // admitted density runtime/deadline, in ppm
+    uint8_t             core;       // core whose density budget admitted the thread
+} noza_edf_t;
+
+// CPU accounting reported by NSC_THREAD_STATS
+typedef struct {
+    uint64_t            run_us;     // time spent on a core
+    uint32_t            voluntary;  // left the core by blocking or yielding in a syscall
+    uint32_t            involuntary;// preempted while still runnable
+    uint32_t            syscalls;
+    uint8_t             last_core;
+} noza_thread_acct_t;
+
 typedef struct {
     uint32_t    priority:8;
     uint32_t    state:8;
     uint32_t    port_state:8;       // PORT_WAIT_LISTEN or PORT_READY
+    uint32_t    base_priority:8;    // priority without priority-inheritance boosts
 } info_t;
 
 typedef struct {
@@ -270,9 +358,57 @@ typedef struct {
     } pid;
     uint32_t   size;
     void       *ptr;
+    uint32_t   word[NOZA_MSG_SHORT_WORDS];  // payload of a NOZA_MSG_SHORT message
     noza_identity_t identity;
 } noza_os_message_t;
 
+#if NOZA_MSG_SHORT_WORDS != ARCH_TRAP_WORDS
+#error "a short message must fit the registers the trap hands back"
+#endif
+
+// kernel port object, addressed by a NOZA_PORT_ID_FLAG id wherever a thread vid is accepted
+typedef struct {
+    thread_list_t   pending_list;   // callers waiting for a receiver, by priority
+    thread_list_t   receivers;      // receivers blocked in NSC_PORT_REPLY_RECV, longest idle first
+    noza_async_list_t async_list;   // async requests waiting for a receiver
+    uint32_t        owner_vid;      // creator, the port is released when it exits
+    uint16_t        gen;            // bumped on every reuse, a stale id fails to resolve
+    uint8_t         in_use;
+} noza_port_t;
+
+// port id layout: NOZA_PORT_ID_FLAG | (generation << NOZA_PORT_INDEX_BITS) | slot
+#define NOZA_PORT_INDEX_BITS    8
+#define NOZA_PORT_INDEX_MASK    ((1u << NOZA_PORT_INDEX_BITS) - 1)
+
+#if NOZA_MAX_PORTS > (1 << NOZA_PORT_INDEX_BITS)
+#error "NOZA_MAX_PORTS does not fit in the port index field"
+#endif
+
+static noza_port_t noza_ports[NOZA_MAX_PORTS];
+
+// asynchronous request (NSC_CALL_ASYNC): waits in the async list of a thread or port like
+// a blocked caller would, is served under its own id, and once replied sits in the
+// completion queue of the thread that sent it until NSC_ASYNC_WAIT collects it
+typedef struct {
+    cdl_node_t          node;
+    noza_async_list_t   *list;      // async list or completion queue holding it, NULL while served
+    noza_os_message_t   message;    // the request, replaced by the reply
+    thread_t            *owner;     // sender, NULL once it exited
+    thread_t            *server;    // receiver working on it
+    uint32_t            tag;        // caller's cookie, handed back with the completion
+    int32_t             status;     // 0 when replied, the error otherwise
+    uint16_t            gen;        // bumped on every reuse, a stale id fails to resolve
+    uint8_t             priority;   // sender priority, ranks it against blocked callers
+    uint8_t             in_use;
+} noza_async_t;
+
+// async ids have the same layout as port ids under NOZA_ASYNC_ID_FLAG
+#if NOZA_MAX_ASYNC > (1 << NOZA_PORT_INDEX_BITS)
+#error "NOZA_MAX_ASYNC does not fit in the port index field"
+#endif
+
+static noza_async_t noza_async[NOZA_MAX_ASYNC];
+
 static const noza_identity_t k_default_identity = {
     .uid = NOZA_DEFAULT_UID,
     .gid = NOZA_DEFAULT_GID,
@@ -287,43 +423,70 @@ typedef struct thread_s {
     cdl_node_t          sync_node;           // node for synchronization wait queues
     info_t              info;                // thread information
     int64_t             expired_time;        // time when the thread expires
+    noza_deadline_t     event;               // deadline queue entry (sleep or sync timeout)
+    noza_edf_t          edf;                 // deadline class parameters and budget
+    noza_thread_acct_t  acct;                // run time and switch counters
     uint32_t            exit_code;           // the exit code
     uint32_t            vid;                 // virtual id
+    uint16_t            vid_gen;             // generation of this TCB slot, bumped on every reuse
     kernel_trap_info_t  trap;                // kernel trap information
     noza_os_port_t      port;                // port information
     noza_os_message_t   message;             // message passing mechanism for the thread
     noza_msg_t          *pending_recv_msg;   // user-space msg buffer for pending recv
+    noza_async_list_t   async_done;          // replied async requests, oldest first
+    noza_async_result_t *async_result;       // where a blocked NSC_ASYNC_WAIT wants the next completion
+    uint16_t            async_count;         // async requests sent and not collected yet
+    uint8_t             poll_kinds;          // 1 << NOZA_WAIT_* of the sources watched in NSC_WAIT_ANY
+    uint8_t             poll_count;          // number of sources watched
+    noza_wait_source_t  *poll_sources;       // the caller's source array while it waits in NSC_WAIT_ANY
+    noza_msg_t          *batch_msgs;         // messages of an NSC_CALL_BATCH in progress, NULL otherwise
+    int32_t             *batch_status;       // per-message status of the batch
+    uint16_t            batch_count;         // number of messages in the batch
+    uint16_t            batch_next;          // message currently sent (or next to send)
     noza_identity_t     identity;            // credentials for permission checks
     thread_t            *join_th;            // thread waiting to join this thread
+    thread_t            *join_target;        // thread this one is joining (PENDING_JOIN)
+    thread_list_t       *port_list;          // pending/reply list (WAITING_READ/REPLY) or receive list (WAITING_MSG) blocked on
     noza_wait_queue_t   *waiting_queue;      // wait queue currently blocked on
+    uintptr_t           futex_key;           // futex address while waiting in a futex bucket
+    uint32_t            futex_bitset;        // wake filter of the futex wait
+    thread_t            *pi_owner;           // PI futex owner this waiter boosts
+    cdl_node_t          pi_node;             // node in pi_owner->pi_waiters
+    cdl_node_t          *pi_waiters;         // threads blocked on PI futexes this thread owns
     uint32_t            signal_pending;      // pending signal bits
     uint32_t            signal_mask;         // masked signals
-    uint32_t            stack_area[NOZA_OS_STACK_SIZE]; // stack memory area for the thread
+    uint32_t            *stack_area;         // kernel-side entry stack, allocated from the arena
+    uint32_t            stack_words;         // size of stack_area in words
+    uint16_t            index;               // slot in noza_os.tcb, the low bits of generated vids
     uint8_t             flags;               // reserved flags
     uint8_t             callid;              // system call id  
+    uint8_t             core;                // core whose ready queue owns the thread (last core it ran on)
+    uint8_t             affinity;            // bit mask of cores allowed to run the thread
 } thread_t;
 
-typedef struct vid_map_item_s {
-    struct vid_map_item_s *next;
-    uint32_t    pid;
+// reserved (well-known) vids that do not follow the generation encoding
+typedef struct {
     uint32_t    vid;
-} vid_map_item_t;
+    thread_t    *thread;
+} vid_alias_t;
 
-#define NUM_VID_SLOT    256
 // Define a structure for Noza OS management
 typedef struct {
     thread_t        *running[NOZA_OS_NUM_CORES];         // array of currently running threads for each core
-    thread_list_t   ready[NOZA_OS_PRIORITY_LIMIT];       // array of ready threads for each priority level
+    thread_list_t   ready[NOZA_OS_NUM_CORES][NOZA_OS_PRIORITY_LIMIT]; // per-core ready threads for each priority level
+    uint32_t        ready_bitmap[NOZA_OS_NUM_CORES];     // bit (31 - priority) set when ready[core][priority] is not empty
+    thread_list_t   edf_ready[NOZA_OS_NUM_CORES];        // per-core ready deadline threads, earliest deadline first
+    uint32_t        edf_util[NOZA_OS_NUM_CORES];         // density admitted per core, in ppm
+    uint32_t        edf_count;                           // threads in the deadline class
+    thread_list_t   throttled;                           // deadline threads waiting for their next period
     thread_list_t   wait;                                // list of threads in waiting state for thread pending on noza_recv
     thread_list_t   sleep;                               // list of threads in sleeping state
-    thread_list_t   sync_sleep;                          // threads waiting on synchronization objects
     thread_list_t   stopped;                            // stopped threads (SIGSTOP)
     thread_list_t   zombie;                              // list of threads in zombie state
     thread_list_t   free;                                // list of free/available threads
-    thread_t        thread[NOZA_OS_TASK_LIMIT];          // array of thread_t structures for task management
-    vid_map_item_t  vid_map[NOZA_OS_TASK_LIMIT];
-    vid_map_item_t  *free_vid_map;
-    vid_map_item_t  *slot[NUM_VID_SLOT];
+    thread_t        *tcb[NOZA_OS_TASK_LIMIT];            // TCB index table, filled as slabs are carved
+    uint32_t        tcb_count;                           // number of TCBs allocated so far
+    vid_alias_t     vid_alias[NOZA_VID_ALIAS_LIMIT];     // reserved vids bound to threads
     int64_t         next_tick_time[NOZA_OS_NUM_CORES];
 } noza_os_t;
 
@@ -333,9 +496,13 @@ typedef struct {
 // declare the Noza kernel data structure instance
 //
 static noza_os_t noza_os;
-static noza_futex_slot_t noza_futex_slots[NOZA_FUTEX_SLOT_COUNT];
+static noza_futex_entry_t *noza_futex_buckets[NOZA_FUTEX_BUCKET_COUNT];
+static noza_futex_entry_t noza_futex_entries[NOZA_FUTEX_ENTRY_COUNT];
+static noza_futex_entry_t *noza_futex_free;
 static noza_timer_t noza_timers[NOZA_MAX_TIMERS];
-static cdl_node_t *noza_timer_head;
+static noza_timer_t *noza_timer_free;
+static noza_deadline_t *noza_deadline_heap[NOZA_DEADLINE_CAPACITY];
+static uint32_t noza_deadline_count;
 static uint32_t noza_timer_seq;
 static int64_t noza_realtime_offset_us;
 static volatile uint32_t futex_wake_counter;
@@ -348,37 +515,176 @@ static uint32_t irq_debug_samples;
 
 static void irq_bindings_init(void);
 static bool irq_try_consume_event(thread_t *running);
-static bool irq_try_handle_reply(thread_t *running);
+static bool irq_try_handle_reply(thread_t *running, uint32_t target_vid);
 static void irq_deliver_if_waiting(uint32_t irq_id);
 void noza_irq_handle_from_isr(uint32_t irq_id);
 #endif
-inline static uint32_t _thread_get_pid(thread_t *th)
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// event trace: one ring per core with a single writer (the core itself) and a single
+// reader (NSC_TRACE_READ), so recording needs no lock. Interrupts are masked only for
+// the few stores of a record, keeping an ISR on the same core from interleaving.
+// A full ring drops the new record and counts it instead of overwriting unread ones.
+//
+#if NOZA_OS_ENABLE_TRACE
+#if (NOZA_TRACE_RING_SIZE & (NOZA_TRACE_RING_SIZE - 1)) != 0
+#error "NOZA_TRACE_RING_SIZE must be a power of two"
+#endif
+
+typedef struct {
+    noza_trace_record_t rec[NOZA_TRACE_RING_SIZE];
+    volatile uint32_t   head;       // records written, advanced by the owning core
+    volatile uint32_t   tail;       // records drained, advanced by the reader
+    volatile uint32_t   lost;       // records dropped while the ring was full
+    uint32_t            lost_seen;  // drops already reported by the reader
+    uint32_t            last_vid;   // thread last switched in, repeats are not recorded
+} noza_trace_ring_t;
+
+static noza_trace_ring_t noza_trace_ring[NOZA_OS_NUM_CORES];
+static volatile uint32_t noza_trace_on = 1;
+
+static void noza_trace(uint32_t event, uint32_t vid, uint32_t arg, uint32_t extra)
 {
-    return (th - (thread_t *)&noza_os.thread[0]);
+    if (!noza_trace_on) {
+        return;
+    }
+    uint32_t time_us = (uint32_t)platform_get_absolute_time_us();
+    uint32_t core = platform_get_running_core();
+    noza_trace_ring_t *ring = &noza_trace_ring[core];
+    uint32_t flags = platform_interrupt_disable();
+    uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= NOZA_TRACE_RING_SIZE) {
+        ring->lost++;
+    } else {
+        noza_trace_record_t *rec = &ring->rec[head & (NOZA_TRACE_RING_SIZE - 1)];
+        rec->time_us = time_us;
+        rec->vid = vid;
+        rec->arg = arg;
+        rec->extra = (uint16_t)extra;
+        rec->event = (uint8_t)event;
+        rec->core = (uint8_t)core;
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    }
+    platform_interrupt_restore(flags);
 }
 
-inline static uint32_t thread_get_vid(thread_t *th)
+static inline void noza_trace_switch(uint32_t core, uint32_t vid)
 {
-    return th->vid;
+    if (noza_trace_ring[core].last_vid != vid) {
+        noza_trace_ring[core].last_vid = vid;
+        noza_trace(NOZA_TRACE_SWITCH, vid, 0, 0);
+    }
 }
 
-static thread_t *get_thread_by_vid(uint32_t vid);
+#define TRACE_EVENT(event, vid, arg, extra) noza_trace((event), (vid), (uint32_t)(arg), (extra))
+#define TRACE_SWITCH(core, vid)             noza_trace_switch((core), (vid))
+#else
+#define TRACE_EVENT(event, vid, arg, extra) ((void)0)
+#define TRACE_SWITCH(core, vid)             ((void)0)
+#endif
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// kernel arena: first-fit allocator for TCB slabs and thread stacks. free blocks are
+// kept in address order so neighbours coalesce on release.
+//
+typedef struct noza_arena_block_s {
+    uint32_t                    size;   // bytes, including the header
+    struct noza_arena_block_s   *next;  // next free block (free blocks only)
+} noza_arena_block_t;
+
+#define NOZA_ARENA_ALIGN        8       // AAPCS stack alignment
+#define NOZA_ARENA_HEADER       ((sizeof(noza_arena_block_t) + NOZA_ARENA_ALIGN - 1) & ~(NOZA_ARENA_ALIGN - 1))
+#define NOZA_TCB_SLAB_COUNT     8       // TCBs carved per slab
+
+static uint64_t noza_arena_pool[NOZA_KERNEL_ARENA_SIZE / sizeof(uint64_t)];
+static noza_arena_block_t *noza_arena_free;
+
+static void noza_arena_init(void)
+{
+    noza_arena_free = (noza_arena_block_t *)noza_arena_pool;
+    noza_arena_free->size = sizeof(noza_arena_pool);
+    noza_arena_free->next = NULL;
+}
 
-inline static int vid_to_pid(uint32_t vid)
+static void *noza_arena_alloc(uint32_t size)
 {
-    vid_map_item_t *vp_map = noza_os.slot[hash32to8(vid)];
-    while (vp_map) {
-        if (vp_map->vid == vid) {
-            return vp_map->pid;
+    size = (size + NOZA_ARENA_HEADER + NOZA_ARENA_ALIGN - 1) & ~(NOZA_ARENA_ALIGN - 1);
+    noza_arena_block_t **link = &noza_arena_free;
+    for (noza_arena_block_t *block = *link; block != NULL; link = &block->next, block = *link) {
+        if (block->size < size) {
+            continue;
+        }
+        if (block->size - size >= NOZA_ARENA_HEADER + NOZA_ARENA_ALIGN) {
+            // split, the tail stays on the free list
+            noza_arena_block_t *rest = (noza_arena_block_t *)((uint8_t *)block + size);
+            rest->size = block->size - size;
+            rest->next = block->next;
+            *link = rest;
+            block->size = size;
+        } else {
+            *link = block->next;
         }
-        vp_map = vp_map->next;
+        return (uint8_t *)block + NOZA_ARENA_HEADER;
+    }
+    return NULL;
+}
+
+static void noza_arena_release(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    noza_arena_block_t *block = (noza_arena_block_t *)((uint8_t *)ptr - NOZA_ARENA_HEADER);
+    noza_arena_block_t *prev = NULL;
+    noza_arena_block_t *next = noza_arena_free;
+    while (next != NULL && next < block) {
+        prev = next;
+        next = next->next;
+    }
+
+    block->next = next;
+    if (next != NULL && (uint8_t *)block + block->size == (uint8_t *)next) {
+        block->size += next->size;
+        block->next = next->next;
     }
-    return -1; // not found
+    if (prev == NULL) {
+        noza_arena_free = block;
+    } else if ((uint8_t *)prev + prev->size == (uint8_t *)block) {
+        prev->size += block->size;
+        prev->next = block->next;
+    } else {
+        prev->next = block;
+    }
+}
+
+inline static uint32_t _thread_get_pid(thread_t *th)
+{
+    return th->index;
+}
+
+inline static uint32_t thread_get_vid(thread_t *th)
+{
+    return th->vid;
 }
 
+static thread_t *get_thread_by_vid(uint32_t vid);
+static cdl_node_t *cdl_add(cdl_node_t *head, cdl_node_t *obj);
+static cdl_node_t *cdl_remove(cdl_node_t *head, cdl_node_t *obj);
+
 static void     noza_os_add_thread(thread_list_t *list, thread_t *thread);
 static void     noza_os_remove_thread(thread_list_t *list, thread_t *thread);
-static uint32_t noza_os_thread_create(uint32_t *pth, void (*entry)(void *param), void *param, uint32_t pri, uint32_t reserved_vid);
+static thread_list_t *noza_ready_list(thread_t *th);
+static thread_list_t *noza_ready_target(thread_t *th);
+inline static int is_with_higher_priority_thread(uint32_t core, thread_t *running);
+static void     noza_batch_reply(thread_t *server, thread_t *client, void *msg, uint32_t size);
+static bool     noza_async_reply(thread_t *server, uint32_t id, void *msg, uint32_t size);
+static void     noza_async_release_list(noza_async_list_t *list, int32_t error);
+static void     noza_poll_kick(uint32_t type, thread_t *only, uintptr_t key);
+static void     noza_edf_release(thread_t *th);
+static inline bool noza_edf_thread(thread_t *th);
+static uint32_t noza_os_thread_create(uint32_t *pth, void (*entry)(void *param), void *param, uint32_t pri,
+    uint32_t reserved_vid, uint32_t stack_words);
 static void     noza_os_scheduler();
 static void     noza_os_change_state(thread_t *th, thread_list_t *from, thread_list_t *to);
 static void     noza_os_set_return_value1(thread_t *th, uint32_t r0);
@@ -396,6 +702,157 @@ static inline void noza_ipc_write_user_message(thread_t *target, uint32_t sender
 #define noza_os_unlock(core)    (void)0
 #endif
 
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// kernel lock domains
+//
+// noza_os_lock() only masks interrupts on the local core, shared state is split into
+// domains with their own spin locks. Lock order (outer to inner):
+//   futex stripe (ascending) -> ipc -> timer -> sched
+// ipc:   port pending/reply lists, the WAITING_MSG list, irq bindings
+// timer: kernel timers, the deadline heap and the sleep list
+// sched: per-core ready queues, running slots and signal bits
+// The futex entry pool lock is a leaf, taken under any of the above.
+// Thread lifecycle (create/kill/join/...) takes every domain.
+//
+static noza_klock_t noza_futex_lock[NOZA_FUTEX_LOCK_COUNT];
+static noza_klock_t noza_futex_pool_lock;
+static noza_klock_t noza_ipc_lock;
+static noza_klock_t noza_timer_lock;
+static noza_klock_t noza_sched_lock;
+
+static noza_wait_queue_t noza_async_waiters; // threads in NSC_ASYNC_WAIT, guarded by the ipc lock
+static noza_wait_queue_t noza_poll_waiters;  // threads in NSC_WAIT_ANY, guarded by the timer lock
+
+#define KLOCK_FUTEX     0x01    // the futex stripe of the address in trap r1
+#define KLOCK_IPC       0x02
+#define KLOCK_TIMER     0x04
+#define KLOCK_SCHED     0x08
+#define KLOCK_ALL       0x10    // every domain, including all futex stripes
+
+static void noza_klock_init(noza_klock_t *lock, const char *name)
+{
+    lock->word = 0;
+    lock->owner = -1;
+    lock->depth = 0;
+    lock->name = name;
+    lock->acquired = 0;
+    lock->contended = 0;
+}
+
+static inline bool noza_klock_try_acquire(noza_klock_t *lock)
+{
+    int32_t core = (int32_t)platform_get_running_core();
+    if (lock->owner == core) {
+        lock->depth++;
+        return true;
+    }
+    if (!platform_spin_try_claim(&lock->word)) {
+        return false;
+    }
+    lock->owner = core;
+    lock->depth = 1;
+    lock->acquired++;
+    return true;
+}
+
+static inline void noza_klock_acquire(noza_klock_t *lock)
+{
+    if (noza_klock_try_acquire(lock)) {
+        return;
+    }
+    lock->contended++; // racy on purpose, a statistic only
+    while (!noza_klock_try_acquire(lock))
+        ;
+}
+
+static inline void noza_klock_release(noza_klock_t *lock)
+{
+    if (--lock->depth == 0) {
+        lock->owner = -1;
+        platform_spin_release(&lock->word);
+    }
+}
+
+static inline noza_klock_t *noza_futex_bucket_lock(uintptr_t key);
+
+static void noza_klock_enter(uint32_t domains, uintptr_t futex_key)
+{
+    if (domains & KLOCK_ALL) {
+        for (int i = 0; i < NOZA_FUTEX_LOCK_COUNT; i++) {
+            noza_klock_acquire(&noza_futex_lock[i]);
+        }
+        domains |= KLOCK_IPC | KLOCK_TIMER | KLOCK_SCHED;
+    } else if (domains & KLOCK_FUTEX) {
+        noza_klock_acquire(noza_futex_bucket_lock(futex_key));
+    }
+    if (domains & KLOCK_IPC)
+        noza_klock_acquire(&noza_ipc_lock);
+    if (domains & KLOCK_TIMER)
+        noza_klock_acquire(&noza_timer_lock);
+    if (domains & KLOCK_SCHED)
+        noza_klock_acquire(&noza_sched_lock);
+}
+
+static void noza_klock_leave(uint32_t domains, uintptr_t futex_key)
+{
+    if (domains & KLOCK_ALL) {
+        domains |= KLOCK_IPC | KLOCK_TIMER | KLOCK_SCHED;
+    }
+    if (domains & KLOCK_SCHED)
+        noza_klock_release(&noza_sched_lock);
+    if (domains & KLOCK_TIMER)
+        noza_klock_release(&noza_timer_lock);
+    if (domains & KLOCK_IPC)
+        noza_klock_release(&noza_ipc_lock);
+    if (domains & KLOCK_ALL) {
+        for (int i = NOZA_FUTEX_LOCK_COUNT - 1; i >= 0; i--) {
+            noza_klock_release(&noza_futex_lock[i]);
+        }
+    } else if (domains & KLOCK_FUTEX) {
+        noza_klock_release(noza_futex_bucket_lock(futex_key));
+    }
+}
+
+static void noza_klock_setup(void)
+{
+    for (int i = 0; i < NOZA_FUTEX_LOCK_COUNT; i++) {
+        noza_klock_init(&noza_futex_lock[i], "futex");
+    }
+    noza_klock_init(&noza_ipc_lock, "ipc");
+    noza_klock_init(&noza_timer_lock, "timer");
+    noza_klock_init(&noza_sched_lock, "sched");
+    noza_klock_init(&noza_futex_pool_lock, "futex pool");
+}
+
+#define NOZA_KLOCK_COUNT    (4 + NOZA_FUTEX_LOCK_COUNT)
+
+// the i-th kernel lock in reporting order, futex stripes last; NULL past the end
+static noza_klock_t *noza_klock_at(uint32_t i, uint32_t *index)
+{
+    noza_klock_t *domains[] = { &noza_ipc_lock, &noza_timer_lock, &noza_sched_lock, &noza_futex_pool_lock };
+    *index = 0;
+    if (i < 4) {
+        return domains[i];
+    }
+    if (i < NOZA_KLOCK_COUNT) {
+        *index = i - 4;
+        return &noza_futex_lock[i - 4];
+    }
+    return NULL;
+}
+
+#if defined(DEBUG)
+static void noza_klock_dump(void)
+{
+    uint32_t index;
+    noza_klock_t *lock;
+    for (uint32_t i = 0; (lock = noza_klock_at(i, &index)) != NULL; i++) {
+        kernel_log("lock %s[%u]: acquired=%u contended=%u\n", lock->name, index, lock->acquired, lock->contended);
+    }
+}
+#endif
+
 #if NOZA_OS_ENABLE_IRQ
 
 static inline uint32_t irq_sender_vid_inline(uint32_t irq_id)
@@ -437,6 +894,7 @@ static void irq_deliver_if_waiting(uint32_t irq_id)
         return;
     }
     if (target->info.state != THREAD_WAITING_MSG || target->info.port_state != PORT_READY) {
+        noza_poll_kick(NOZA_WAIT_IRQ, target, irq_id);
         kernel_log("[irq] deliver irq %u owner vid %u state=%u port=%u\n",
             irq_id, binding->owner_vid, target->info.state, target->info.port_state);
         return;
@@ -445,7 +903,7 @@ static void irq_deliver_if_waiting(uint32_t irq_id)
     binding->queued = 0;
     binding->inflight = 1;
     irq_prepare_user_message(target, binding);
-    noza_os_change_state(target, &noza_os.wait, &noza_os.ready[target->info.priority]);
+    noza_os_change_state(target, &noza_os.wait, noza_ready_target(target));
 }
 
 static int32_t irq_fetch_next_pending(void)
@@ -468,7 +926,9 @@ static void irq_process_pending(void)
         int32_t irq_id = irq_fetch_next_pending();
         if (irq_id < 0)
             break;
+        noza_klock_acquire(&noza_ipc_lock);
         irq_deliver_if_waiting((uint32_t)irq_id);
+        noza_klock_release(&noza_ipc_lock);
     }
 }
 
@@ -488,10 +948,8 @@ static bool irq_try_consume_event(thread_t *running)
     return false;
 }
 
-static bool irq_try_handle_reply(thread_t *running)
+static bool irq_try_handle_reply(thread_t *running, uint32_t target_vid)
 {
-    kernel_trap_info_t *trap = &running->trap;
-    uint32_t target_vid = trap->r1;
     if (!NOZA_IRQ_IS_KERNEL_VID(target_vid))
         return false;
     uint32_t irq_id = NOZA_IRQ_SENDER_TO_ID(target_vid);
@@ -513,6 +971,7 @@ void noza_irq_handle_from_isr(uint32_t irq_id)
 {
     if (irq_id >= NOZA_PLATFORM_IRQ_COUNT)
         return;
+    TRACE_EVENT(NOZA_TRACE_IRQ, 0, irq_id, 0);
     irq_binding_t *binding = &irq_bindings[irq_id];
     if (binding->owner_vid == 0)
         return;
@@ -544,23 +1003,23 @@ inline static void dump_threads()
         total_threads++;
     }
 
-    for (int i=0; i < NOZA_OS_PRIORITY_LIMIT; i++) {
-        if (noza_os.ready[i].count > 0) {
-            ready_count += noza_os.ready[i].count;
+    for (int c=0; c < NOZA_OS_NUM_CORES; c++) {
+        for (int i=0; i < NOZA_OS_PRIORITY_LIMIT; i++) {
+            ready_count += noza_os.ready[c][i].count;
         }
     }
 
-    for (int i=0; i < NOZA_OS_TASK_LIMIT; i++) {
-        if (noza_os.thread[i].join_th) {
+    for (uint32_t i=0; i < noza_os.tcb_count; i++) {
+        if (noza_os.tcb[i]->join_th) {
             join_pending_count++;
         }
     }
 
-    for (int i=0; i< NOZA_OS_TASK_LIMIT; i++) {
-        if (noza_os.thread[i].port.pending_list.count > 0) {
+    for (uint32_t i=0; i < noza_os.tcb_count; i++) {
+        if (noza_os.tcb[i]->port.pending_list.count > 0) {
             waiting_read++;
         }
-        if (noza_os.thread[i].port.reply_list.count > 0) {
+        if (noza_os.tcb[i]->port.reply_list.count > 0) {
             waiting_reply++;
         }
     }
@@ -570,8 +1029,8 @@ inline static void dump_threads()
         join_pending_count, ready_count,
         noza_os.wait.count, noza_os.sleep.count, noza_os.stopped.count, noza_os.zombie.count, noza_os.free.count, waiting_read, waiting_reply);
     kernel_log("total_threads=%d, NOZA_OS_TASK_LIMIT=%d\n", total_threads, NOZA_OS_TASK_LIMIT);
-    for (int i=0; i< NOZA_OS_TASK_LIMIT; i++) {
-        thread_t *th = &noza_os.thread[i];
+    for (uint32_t i=0; i < noza_os.tcb_count; i++) {
+        thread_t *th = noza_os.tcb[i];
         if (th->info.state != THREAD_FREE) {
             if (th->join_th) {
                 kernel_log("pid: %d, %s, pending_join: %d\n", thread_get_pid(th),
@@ -605,6 +1064,7 @@ inline static void dump_threads()
             }
         }
     }
+    noza_klock_dump();
 }
 #endif
 
@@ -668,6 +1128,16 @@ inline static void noza_ipc_write_user_message(thread_t *target, uint32_t sender
     target->pending_recv_msg = NULL;
 }
 
+// a short message is handed to the receiver in r4-r7, next to the usual return registers
+inline static void noza_ipc_write_short_words(thread_t *target, const noza_os_message_t *message)
+{
+    if (message->size != NOZA_MSG_SHORT) {
+        return;
+    }
+    memcpy(target->trap.word, message->word, sizeof(target->trap.word));
+    target->trap.word_output = 1;
+}
+
 inline static void noza_os_change_state(thread_t *th, thread_list_t *from, thread_list_t *to)
 {
     noza_os_remove_thread(from, th);
@@ -689,41 +1159,155 @@ inline static void noza_os_clear_running_thread()
 // 
 // Noza IPC 
 // 
-static void noza_os_send(thread_t *running, thread_t *target, void *msg, uint32_t size)
+
+// L4-style direct switch: make target the running thread of this core, so the scheduler
+// resumes it right after the syscall without a pass through the ready queues. Only done
+// when target may run here, a deadline thread only on the core it was admitted to, and
+// nothing more urgent is queued on this core.
+static bool noza_ipc_switch_to(thread_t *target)
 {
-    if (target->info.state == THREAD_FREE || target->info.state == THREAD_ZOMBIE) {
-        noza_os_set_return_value1(running, ESRCH); // error, not found
-        return;
+    uint32_t core = platform_get_running_core();
+    bool switched = false;
+    noza_klock_acquire(&noza_sched_lock);
+    if ((target->affinity & (1u << core)) != 0 &&
+        (!noza_edf_thread(target) || target->edf.core == core) &&
+        !is_with_higher_priority_thread(core, target)) {
+        target->core = (uint8_t)core;
+        target->info.state = THREAD_RUNNING;
+        noza_os.running[core] = target;
+        switched = true;
+    }
+    noza_klock_release(&noza_sched_lock);
+    return switched;
+}
+
+static void noza_ipc_fill_message(noza_os_message_t *message, const noza_identity_t *identity,
+    uint32_t target_id, void *msg, uint32_t size, const uint32_t *words)
+{
+    noza_ipc_snapshot_identity(message, identity);
+    message->pid.target = target_id;
+    message->ptr = msg;
+    message->size = size;
+    if (size == NOZA_MSG_SHORT) {
+        // the receiver never sees a client address
+        memcpy(message->word, words, sizeof(message->word));
+        message->ptr = NULL;
+    }
+}
+
+// record what running sends, the receiver may pick it up long after this trap; the words
+// of a short message come from words, or from the sender's r4-r7 when words is NULL
+static void noza_ipc_prepare_message(thread_t *running, uint32_t target_id, void *msg, uint32_t size,
+    const uint32_t *words)
+{
+    uint32_t frame_words[NOZA_MSG_SHORT_WORDS];
+    if (size == NOZA_MSG_SHORT && words == NULL) {
+        arch_trap_get_words(running->stack_ptr, frame_words);
+        words = frame_words;
+    }
+    noza_ipc_fill_message(&running->message, &running->identity, target_id, msg, size, words);
+    TRACE_EVENT(NOZA_TRACE_IPC_SEND, thread_get_vid(running), target_id, size);
+}
+
+// hand a message to a receiver that returns from its recv
+static void noza_ipc_deliver_message(thread_t *receiver, uint32_t sender_id, const noza_os_message_t *message)
+{
+    TRACE_EVENT(NOZA_TRACE_IPC_RECV, thread_get_vid(receiver), sender_id, message->size);
+    noza_ipc_write_user_message(receiver, sender_id, message->ptr, message->size, &message->identity);
+    noza_os_set_return_value4(receiver, 0, sender_id, (uint32_t)message->ptr, message->size);
+    noza_ipc_write_short_words(receiver, message);
+}
+
+static void noza_ipc_deliver(thread_t *receiver, thread_t *source)
+{
+    noza_ipc_deliver_message(receiver, thread_get_vid(source), &source->message);
+}
+
+static inline uint32_t noza_async_id(noza_async_t *req)
+{
+    return NOZA_ASYNC_ID_FLAG | ((uint32_t)req->gen << NOZA_PORT_INDEX_BITS) | (uint32_t)(req - noza_async);
+}
+
+static void noza_async_link(noza_async_list_t *list, noza_async_t *req)
+{
+    list->head = cdl_add(list->head, &req->node);
+    list->count++;
+    req->list = list;
+}
+
+static void noza_async_unlink(noza_async_t *req)
+{
+    if (req->list != NULL) {
+        req->list->head = cdl_remove(req->list->head, &req->node);
+        req->list->count--;
+        req->list = NULL;
+    }
+}
+
+// the oldest async request is received ahead of blocked callers only when its sender
+// was more urgent than all of them
+static noza_async_t *noza_async_pick(noza_async_list_t *async_list, thread_list_t *pending_list)
+{
+    if (async_list->count == 0) {
+        return NULL;
+    }
+    noza_async_t *req = async_list->head->value;
+    if (pending_list->count > 0 && ((thread_t *)pending_list->head->value)->info.priority <= req->priority) {
+        return NULL;
     }
+    return req;
+}
+
+static void noza_async_deliver(thread_t *receiver, noza_async_t *req)
+{
+    noza_async_unlink(req);
+    req->server = receiver;
+    noza_ipc_deliver_message(receiver, noza_async_id(req), &req->message);
+}
 
-    noza_ipc_snapshot_identity(&running->message, &running->identity);
-    uint32_t sender_vid = thread_get_vid(running);
-    running->message.pid.target = thread_get_vid(target);
-    running->message.ptr = msg;
-    running->message.size = size;
+// queue the prepared message of client on target; a target already blocked in its recv
+// takes it at once and is returned, the caller makes it runnable
+static thread_t *noza_ipc_post(thread_t *client, thread_t *target)
+{
     switch (target->info.port_state) {
         case PORT_READY:
             // if the target port is ready, then the target thread is blocked in the wait list
             // change the target thread state from wait list to ready list
-            noza_os_add_thread(&target->port.reply_list, running); // move current running thread to reply list
+            noza_os_add_thread(&target->port.reply_list, client); // move the client to reply list
             // target thread should be in the wait list already, because the port state is PORT_READY
             // so just change the state from wait list to ready list
             if (target->info.state != THREAD_WAITING_MSG) {
                 kernel_panic("unexpected: target thread (pid:%ld) is not in the waiting list\n", thread_get_vid(target));
             }
-            noza_os_change_state(target, &noza_os.wait, &noza_os.ready[target->info.priority]);  // move target from wait list to ready list
-            noza_ipc_write_user_message(target, sender_vid, msg, size, &running->message.identity);
-            noza_os_set_return_value4(target, 0, sender_vid, (uint32_t)msg, size); // 0 --> success
+            noza_ipc_deliver(target, client);
             target->info.port_state = PORT_WAIT_LISTEN; 
-            break;
+            noza_os_remove_thread(&noza_os.wait, target);
+            return target;
 
         case PORT_WAIT_LISTEN:
-            // because the running state is already not on the ready list
+        default:
+            // because the client is already not on the ready list
             // just add it into pending list 
-            noza_os_add_thread(&target->port.pending_list, running);
-            break;
+            noza_os_add_thread(&target->port.pending_list, client);
+            noza_poll_kick(NOZA_WAIT_PORT, target, 0);
+            return NULL;
+    }
+}
+
+static void noza_os_send(thread_t *running, thread_t *target, void *msg, uint32_t size)
+{
+    if (target->info.state == THREAD_FREE || target->info.state == THREAD_ZOMBIE) {
+        noza_os_set_return_value1(running, ESRCH); // error, not found
+        return;
     }
+
+    noza_ipc_prepare_message(running, thread_get_vid(target), msg, size, NULL);
+    thread_t *receiver = noza_ipc_post(running, target);
     noza_os_clear_running_thread(); // clear the running thread
+    // the client blocks for the reply, run the server on this core straight away
+    if (receiver != NULL && !noza_ipc_switch_to(receiver)) {
+        noza_os_add_thread(noza_ready_target(receiver), receiver);
+    }
 }
 
 static void noza_os_nonblock_send(thread_t *running, thread_t *target, void *msg, uint32_t size)
@@ -738,11 +1322,12 @@ static void noza_os_nonblock_send(thread_t *running, thread_t *target, void *msg
 static void noza_os_recv(thread_t *running, noza_msg_t *msg)
 {
     running->pending_recv_msg = msg;
-    if (running->port.pending_list.count > 0) {
+    noza_async_t *req = noza_async_pick(&running->port.async_list, &running->port.pending_list);
+    if (req != NULL) {
+        noza_async_deliver(running, req);
+    } else if (running->port.pending_list.count > 0) {
         thread_t *source = running->port.pending_list.head->value; // get the first node in pending_list
-        noza_ipc_write_user_message(running, thread_get_vid(source), source->message.ptr,
-            source->message.size, &source->message.identity);
-        noza_os_set_return_value4(running, 0, thread_get_vid(source), (uint32_t)source->message.ptr, source->message.size); // receive successfully
+        noza_ipc_deliver(running, source); // receive successfully
         noza_os_change_state(source, &running->port.pending_list, &running->port.reply_list); // move from pending list to reply list
     } else {
         // change port stateu to READY and move the running thread to wait list (wait for messages)
@@ -754,7 +1339,7 @@ static void noza_os_recv(thread_t *running, noza_msg_t *msg)
 
 static void noza_os_nonblock_recv(thread_t *running, noza_msg_t *msg)
 {
-    if (running->port.pending_list.count > 0) {
+    if (running->port.pending_list.count > 0 || running->port.async_list.count > 0) {
         noza_os_recv(running, msg);
     } else {
         running->pending_recv_msg = NULL;
@@ -762,172 +1347,427 @@ static void noza_os_nonblock_recv(thread_t *running, noza_msg_t *msg)
     }
 }
 
-static void noza_os_reply(thread_t *running, uint32_t vid, void *msg, uint32_t size)
+// unblock the client vid parked on the running server's reply list, NULL when it is gone
+static thread_t *noza_ipc_complete_reply(thread_t *running, uint32_t vid, void *msg, uint32_t size)
 {
     // sanity check
     if (running->info.port_state != PORT_WAIT_LISTEN) {
         kernel_panic("unexpected: running thread (pid:%ld), port is not PORT_WAIT_LISTEN\n", thread_get_vid(running));
     }
-    // search if pid is in the reply list (sanity check)
-    thread_t *head_th = (thread_t *)running->port.reply_list.head->value;
-    thread_t *th = head_th;
-    while (th) {
-        if (thread_get_vid(th) == vid) {
-            break;
-        }
-        th = th->state_node.next->value;
-        if (th == head_th) { // not found in reply list !
-            kernel_panic("unexpected: noza_os_reply thread not found in reply list: pid=%ld\n", vid);
-            noza_os_set_return_value1(running, ESRCH); // error, not found
-            return;
-        }
+    TRACE_EVENT(NOZA_TRACE_IPC_REPLY, thread_get_vid(running), vid, size);
+    // the client must be parked on this thread's reply list
+    if (NOZA_ASYNC_IS_ID(vid)) {
+        noza_async_reply(running, vid, msg, size);
+        return NULL; // the sender did not block, nothing to resume
     }
-
-    if (th->info.state == THREAD_FREE || th->info.state == THREAD_ZOMBIE) {
-        noza_os_set_return_value1(running, ESRCH); // error, not found
-        return;
+    thread_t *th = get_thread_by_vid(vid);
+    if (th == NULL || th->port_list != &running->port.reply_list) {
+        return NULL; // not found (or already interrupted)
+    }
+    if (th->batch_msgs != NULL) {
+        noza_os_remove_thread(&running->port.reply_list, th);
+        noza_batch_reply(running, th, msg, size);
+        return th;
     }
 
-    noza_os_change_state(th, &running->port.reply_list, &noza_os.ready[th->info.priority]);
-    noza_os_set_return_value3(th, 0, (uint32_t)msg, size); // 0 -> send/reply success
-    noza_os_set_return_value1(running, 0); // success
+    noza_os_set_return_value4(th, 0, vid, (uint32_t)msg, size); // 0 -> send/reply success
+    if (size == NOZA_MSG_SHORT) {
+        // the reply payload is in the server's r4-r7
+        arch_trap_get_words(running->stack_ptr, th->trap.word);
+        th->trap.word_output = 1;
+        th->trap.r2 = 0;
+    }
+    noza_os_remove_thread(&running->port.reply_list, th);
+    return th;
 }
 
-static void noza_make_idle_context(uint32_t core);
-
-// start the noza os
-static void noza_init()
+// make a replied client runnable; a server that is still running only hands the core
+// over to a client that is at least as urgent, and then waits in the ready queue
+static void noza_ipc_resume_client(thread_t *server, thread_t *client)
 {
-    platform_io_init(); // initial all state in platform
-
-    // init noza os / thread structure
-    memset(&noza_os, 0, sizeof(noza_os_t));
-    memset(noza_futex_slots, 0, sizeof(noza_futex_slots));
-    memset(noza_timers, 0, sizeof(noza_timers));
-    noza_timer_head = NULL;
-    noza_timer_seq = 1;
-    noza_realtime_offset_us = 0;
-    noza_os_lock_init();
-    for (int i=0; i<NOZA_OS_PRIORITY_LIMIT; i++) {
-        noza_os.ready[i].state_id = THREAD_READY;
+    if (client->port_list != NULL) {
+        return; // a batched call went on to its next message
     }
-    noza_os.wait.state_id = THREAD_WAITING_MSG;
-    noza_os.sleep.state_id = THREAD_SLEEP;
-    noza_os.sync_sleep.state_id = THREAD_WAITING_SYNC;
-    noza_os.stopped.state_id = THREAD_STOPPED;
-    noza_os.free.state_id = THREAD_FREE;
-    noza_os.zombie.state_id = THREAD_ZOMBIE;
-
-    // init all thread structure
-    for (int i=0; i<NOZA_OS_TASK_LIMIT; i++) {
-        noza_os.thread[i].state_node.value = &noza_os.thread[i];
-        noza_os.thread[i].sync_node.value = &noza_os.thread[i];
-        noza_os.thread[i].waiting_queue = NULL;
-        noza_os_add_thread(&noza_os.free, &noza_os.thread[i]);
-        noza_os.thread[i].port.pending_list.state_id = THREAD_WAITING_READ;
-        noza_os.thread[i].port.reply_list.state_id = THREAD_WAITING_REPLY;
-        noza_os.thread[i].join_th = NULL;
-        noza_os.thread[i].callid = -1;
-        noza_os.thread[i].signal_pending = 0;
-        noza_os.thread[i].signal_mask = 0;
-    }
-
-    for (int i = 0; i < NOZA_MAX_TIMERS; i++) {
-        noza_wait_queue_init(&noza_timers[i].wait_queue);
-        noza_timers[i].node.value = &noza_timers[i];
+    bool server_running = (noza_os_get_running_thread() == server);
+    if (server_running && client->info.priority > server->info.priority) {
+        noza_os_add_thread(noza_ready_target(client), client);
+    } else if (!noza_ipc_switch_to(client)) {
+        noza_os_add_thread(noza_ready_target(client), client);
+    } else if (server_running) {
+        noza_os_add_thread(noza_ready_target(server), server);
     }
+}
 
-    // init all vid slots
-    for (int i=0; i<NOZA_OS_TASK_LIMIT-1; i++) {
-        noza_os.vid_map[i].next = &noza_os.vid_map[i+1];
+static void noza_os_reply(thread_t *running, uint32_t vid, void *msg, uint32_t size)
+{
+    if (NOZA_ASYNC_IS_ID(vid)) {
+        noza_os_set_return_value1(running, noza_async_reply(running, vid, msg, size) ? 0 : ESRCH);
+        return;
     }
-    noza_os.vid_map[NOZA_OS_TASK_LIMIT-1].next = NULL;
-    noza_os.free_vid_map = &noza_os.vid_map[0];
-
-#if NOZA_OS_ENABLE_IRQ
-    irq_bindings_init();
-    platform_irq_init();
-    kernel_log("[boot] irq subsystem ready\n");
-#endif
-
-    // init all running thread to NULL
-    for (int i=0; i<NOZA_OS_NUM_CORES; i++) {
-        noza_make_idle_context(i);
+    thread_t *th = noza_ipc_complete_reply(running, vid, msg, size);
+    if (th == NULL) {
+        noza_os_set_return_value1(running, ESRCH); // error, not found (or already interrupted)
+        return;
     }
+    noza_os_set_return_value1(running, 0); // success
+    noza_ipc_resume_client(running, th);
 }
 
-extern void noza_root_task(); // ini syslib.c
-static void noza_run()
+// port objects: a queue of callers shared by any number of receiver threads. A caller
+// is handed to the longest idle receiver and then waits on that receiver's reply list,
+// so the reply path is the same as for a thread port.
+static inline uint32_t noza_port_id(noza_port_t *port)
 {
-    uint32_t th;
-    noza_os_thread_create(&th, noza_root_task, NULL, 0, NOZA_VID_AUTO); // create the first task
-    kernel_log("[boot] root task vid=%u created\n", th);
-    // TODO: set th as detach, after creating the first user process, just exit
-    noza_os_scheduler(); // start os scheduler and never return
+    return NOZA_PORT_ID_FLAG | ((uint32_t)port->gen << NOZA_PORT_INDEX_BITS) | (uint32_t)(port - noza_ports);
 }
 
-inline static void noza_os_insert_vid_with_value(thread_t *src_th, uint32_t vid)
+static noza_port_t *noza_port_get(uint32_t port_id)
 {
-    // add virtual pid slot
-    vid_map_item_t *vp_map = noza_os.free_vid_map;
-    if (vp_map==NULL) {
-        kernel_panic("fatal error: noza_thread_alloc: free_vid_map is NULL\n");
+    uint32_t index = port_id & NOZA_PORT_INDEX_MASK;
+    if (!NOZA_PORT_IS_ID(port_id) || index >= NOZA_MAX_PORTS) {
+        return NULL;
     }
-    noza_os.free_vid_map = vp_map->next;
-    vp_map->vid = vid;
-    vp_map->pid = _thread_get_pid(src_th);
-    src_th->vid = vid;
-    int hash = hash32to8(vid);
-    vp_map->next = noza_os.slot[hash]; // insert to the head of the list
-    noza_os.slot[hash] = vp_map;
+    noza_port_t *port = &noza_ports[index];
+    if (!port->in_use || noza_port_id(port) != port_id) {
+        return NULL; // free, or a stale id of an earlier port in this slot
+    }
+    return port;
 }
 
-inline static void noza_os_insert_vid(thread_t *src_th)
+// as noza_ipc_post, the longest idle receiver of port takes the message
+static thread_t *noza_port_post(thread_t *client, noza_port_t *port)
 {
-    static uint32_t ID = 1;
-    uint32_t vid = ID++;
-    if (ID >= 65536)
-        ID = 1; // wrap but keep 0 reserved
+    if (port->receivers.count == 0) {
+        noza_os_add_thread(&port->pending_list, client);
+        noza_poll_kick(NOZA_WAIT_PORT, NULL, noza_port_id(port));
+        return NULL;
+    }
+    thread_t *receiver = port->receivers.head->value;
+    noza_os_remove_thread(&port->receivers, receiver);
+    noza_os_add_thread(&receiver->port.reply_list, client);
+    noza_ipc_deliver(receiver, client);
+    return receiver;
+}
 
-    while (get_thread_by_vid(vid) != NULL) {
-        vid = ID++;
-        if (ID >= 65536) {
-            ID = 1;
-        }
+static void noza_port_send(thread_t *running, noza_port_t *port, void *msg, uint32_t size)
+{
+    noza_ipc_prepare_message(running, noza_port_id(port), msg, size, NULL);
+    thread_t *receiver = noza_port_post(running, port);
+    noza_os_clear_running_thread();
+    if (receiver != NULL && !noza_ipc_switch_to(receiver)) {
+        noza_os_add_thread(noza_ready_target(receiver), receiver);
+    }
+}
+
+static void noza_port_recv(thread_t *running, noza_port_t *port, noza_msg_t *msg)
+{
+    running->pending_recv_msg = msg;
+    noza_async_t *req = noza_async_pick(&port->async_list, &port->pending_list);
+    if (req != NULL) {
+        noza_async_deliver(running, req);
+    } else if (port->pending_list.count > 0) {
+        thread_t *source = port->pending_list.head->value;
+        noza_ipc_deliver(running, source);
+        noza_os_change_state(source, &port->pending_list, &running->port.reply_list);
+    } else {
+        noza_os_add_thread(&port->receivers, running);
+        noza_os_clear_running_thread();
     }
+}
 
-    noza_os_insert_vid_with_value(src_th, vid);
+// fail every caller and idle receiver of port with error and free the slot
+static void noza_port_release(noza_port_t *port, uint32_t error)
+{
+    noza_async_release_list(&port->async_list, error);
+    while (port->pending_list.count > 0) {
+        thread_t *pending = (thread_t *)port->pending_list.head->value;
+        noza_os_set_return_value1(pending, error);
+        noza_os_change_state(pending, &port->pending_list, noza_ready_target(pending));
+    }
+    while (port->receivers.count > 0) {
+        thread_t *receiver = (thread_t *)port->receivers.head->value;
+        receiver->pending_recv_msg = NULL;
+        noza_os_set_return_value1(receiver, error);
+        noza_os_change_state(receiver, &port->receivers, noza_ready_target(receiver));
+    }
+    port->in_use = 0;
+    port->gen++; // stale ids of this slot stop resolving
 }
 
-inline static void noza_os_remove_vid(thread_t *src_th)
+// ports go away with the thread that created them
+static void noza_port_release_owned(thread_t *owner)
 {
-    uint32_t pid = _thread_get_pid(src_th);
-    int hash = hash32to8(src_th->vid);
+    for (int i = 0; i < NOZA_MAX_PORTS; i++) {
+        if (noza_ports[i].in_use && noza_ports[i].owner_vid == thread_get_vid(owner)) {
+            noza_port_release(&noza_ports[i], ESRCH);
+        }
+    }
+}
 
-    vid_map_item_t *prev = NULL;
-    vid_map_item_t *vp_map = noza_os.slot[hash];
-    while (vp_map) {
-        if (vp_map->pid == pid) { // match
-            if (prev != NULL) {
-                prev->next = vp_map->next;
-            } else {
-                noza_os.slot[hash] = vp_map->next;
+// NSC_CALL_BATCH: the messages of a batch are sent one after the other from inside the
+// kernel. Each reply records its result and submits the next message on behalf of the
+// caller, which stays blocked on a reply or pending list until the last one is answered.
+static bool noza_batch_submit(thread_t *client, thread_t **receiver)
+{
+    *receiver = NULL;
+    while (client->batch_next < client->batch_count) {
+        noza_msg_t *m = &client->batch_msgs[client->batch_next];
+        if (NOZA_PORT_IS_ID(m->to_vid)) {
+            noza_port_t *port = noza_port_get(m->to_vid);
+            if (port != NULL) {
+                noza_ipc_prepare_message(client, m->to_vid, m->ptr, m->size, m->word);
+                *receiver = noza_port_post(client, port);
+                return true;
+            }
+        } else {
+            thread_t *target = get_thread_by_vid(m->to_vid);
+            if (target != NULL && target->info.state != THREAD_FREE && target->info.state != THREAD_ZOMBIE) {
+                noza_ipc_prepare_message(client, m->to_vid, m->ptr, m->size, m->word);
+                *receiver = noza_ipc_post(client, target);
+                return true;
             }
-            vp_map->next = noza_os.free_vid_map;
-            noza_os.free_vid_map = vp_map;
+        }
+        client->batch_status[client->batch_next++] = ESRCH; // unreachable, go on with the rest
+    }
+    return false;
+}
+
+// the batch returns 0 when every message was replied, otherwise its first failure
+static void noza_batch_finish(thread_t *client)
+{
+    int32_t result = 0;
+    for (uint32_t i = 0; i < client->batch_count; i++) {
+        if (client->batch_status[i] != 0) {
+            result = client->batch_status[i];
+            break;
+        }
+    }
+    noza_os_set_return_value1(client, result);
+}
+
+// server replied to the current message of client's batch: the reply lands in that
+// message, and the client either waits for the next one or is done
+static void noza_batch_reply(thread_t *server, thread_t *client, void *msg, uint32_t size)
+{
+    noza_msg_t *m = &client->batch_msgs[client->batch_next];
+    m->ptr = msg;
+    m->size = size;
+    if (size == NOZA_MSG_SHORT) {
+        arch_trap_get_words(server->stack_ptr, m->word);
+        m->ptr = NULL;
+    }
+    client->batch_status[client->batch_next++] = 0;
+
+    thread_t *receiver;
+    if (noza_batch_submit(client, &receiver)) {
+        if (receiver != NULL) {
+            noza_os_add_thread(noza_ready_target(receiver), receiver); // the replying server keeps the core
+        }
+        return;
+    }
+    noza_batch_finish(client);
+}
+
+static void noza_make_idle_context(uint32_t core);
+
+static void noza_kdata_init(void)
+{
+    memset(&noza_kdata, 0, sizeof(noza_kdata));
+    noza_kdata.num_cores = NOZA_OS_NUM_CORES;
+    noza_kdata.clock_hz = platform_get_clock_hz();
+    noza_kdata.clock_mult = (uint32_t)((1000000ull << NOZA_KDATA_CLOCK_SHIFT) / noza_kdata.clock_hz);
+    noza_kdata.clock_shift = NOZA_KDATA_CLOCK_SHIFT;
+    noza_kdata.realtime_offset_us = noza_realtime_offset_us;
+    __atomic_store_n(&noza_kdata.version, NOZA_KDATA_VERSION, __ATOMIC_RELEASE);
+}
+
+// start the noza os
+static void noza_init()
+{
+    platform_io_init(); // initial all state in platform
+
+    // init noza os / thread structure
+    memset(&noza_os, 0, sizeof(noza_os_t));
+    memset(noza_timers, 0, sizeof(noza_timers));
+    noza_timer_free = NULL;
+    noza_deadline_count = 0;
+    noza_timer_seq = 1;
+    noza_realtime_offset_us = 0;
+    noza_kdata_init();
+    noza_os_lock_init();
+    noza_klock_setup();
+    memset(noza_futex_buckets, 0, sizeof(noza_futex_buckets));
+    noza_futex_free = NULL;
+    for (int i = NOZA_FUTEX_ENTRY_COUNT - 1; i >= 0; i--) {
+        noza_futex_entries[i].next = noza_futex_free;
+        noza_futex_free = &noza_futex_entries[i];
+    }
+    for (int c=0; c<NOZA_OS_NUM_CORES; c++) {
+        for (int i=0; i<NOZA_OS_PRIORITY_LIMIT; i++) {
+            noza_os.ready[c][i].state_id = THREAD_READY;
+        }
+    }
+    noza_os.wait.state_id = THREAD_WAITING_MSG;
+    memset(noza_ports, 0, sizeof(noza_ports));
+    memset(noza_async, 0, sizeof(noza_async));
+    for (int i = 0; i < NOZA_MAX_ASYNC; i++) {
+        noza_async[i].node.value = &noza_async[i];
+        noza_async[i].gen = 1;
+    }
+    noza_wait_queue_init(&noza_async_waiters, &noza_ipc_lock);
+    noza_wait_queue_init(&noza_poll_waiters, &noza_timer_lock);
+    for (int i = 0; i < NOZA_MAX_PORTS; i++) {
+        noza_ports[i].pending_list.state_id = THREAD_WAITING_READ;
+        noza_ports[i].receivers.state_id = THREAD_WAITING_MSG;
+        noza_ports[i].gen = 1;
+    }
+    noza_os.sleep.state_id = THREAD_SLEEP;
+    noza_os.stopped.state_id = THREAD_STOPPED;
+    noza_os.free.state_id = THREAD_FREE;
+    noza_os.zombie.state_id = THREAD_ZOMBIE;
+    noza_os.throttled.state_id = THREAD_THROTTLED;
+    for (int c = 0; c < NOZA_OS_NUM_CORES; c++) {
+        noza_os.edf_ready[c].state_id = THREAD_READY;
+    }
+
+    // TCBs and thread stacks are carved from the kernel arena on demand
+    noza_arena_init();
+    noza_os.tcb_count = 0;
+
+    for (int i = NOZA_MAX_TIMERS - 1; i >= 0; i--) {
+        noza_wait_queue_init(&noza_timers[i].wait_queue, &noza_timer_lock);
+        noza_timers[i].event.slot = NOZA_DEADLINE_IDLE;
+        noza_timers[i].event.kind = NOZA_DEADLINE_TIMER;
+        noza_timers[i].next_free = noza_timer_free;
+        noza_timer_free = &noza_timers[i];
+    }
+
+    // init all vid aliases
+    for (int i=0; i<NOZA_VID_ALIAS_LIMIT; i++) {
+        noza_os.vid_alias[i].thread = NULL;
+    }
+
+#if NOZA_OS_ENABLE_IRQ
+    irq_bindings_init();
+    platform_irq_init();
+    kernel_log("[boot] irq subsystem ready\n");
+#endif
+
+    // init all running thread to NULL
+    for (int i=0; i<NOZA_OS_NUM_CORES; i++) {
+        noza_make_idle_context(i);
+    }
+}
+
+extern void noza_root_task(); // ini syslib.c
+static void noza_run()
+{
+    uint32_t th;
+    noza_os_thread_create(&th, noza_root_task, NULL, 0, NOZA_VID_AUTO, NOZA_OS_STACK_SIZE); // create the first task
+    kernel_log("[boot] root task vid=%u created\n", th);
+    // TODO: set th as detach, after creating the first user process, just exit
+    noza_os_scheduler(); // start os scheduler and never return
+}
+
+// bind a reserved vid to the thread, replacing its generated vid
+inline static bool noza_os_alias_vid(thread_t *src_th, uint32_t vid)
+{
+    for (int i = 0; i < NOZA_VID_ALIAS_LIMIT; i++) {
+        vid_alias_t *alias = &noza_os.vid_alias[i];
+        if (alias->thread == NULL) {
+            alias->vid = vid;
+            alias->thread = src_th;
+            src_th->vid = vid;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline static bool noza_os_vid_aliased(uint32_t vid)
+{
+    for (int i = 0; i < NOZA_VID_ALIAS_LIMIT; i++) {
+        if (noza_os.vid_alias[i].thread != NULL && noza_os.vid_alias[i].vid == vid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline static void noza_os_insert_vid(thread_t *src_th)
+{
+    uint32_t gen = src_th->vid_gen;
+    uint32_t vid;
+    do {
+        if (++gen >= NOZA_VID_GEN_LIMIT)
+            gen = 1; // wrap but keep generation 0 unused
+        vid = (gen << NOZA_VID_INDEX_BITS) | _thread_get_pid(src_th);
+    } while (noza_os_vid_aliased(vid)); // never shadow a reserved vid
+    src_th->vid_gen = (uint16_t)gen;
+    src_th->vid = vid;
+}
+
+inline static void noza_os_remove_vid(thread_t *src_th)
+{
+    // drop the reserved alias, if any
+    for (int i = 0; i < NOZA_VID_ALIAS_LIMIT; i++) {
+        if (noza_os.vid_alias[i].thread == src_th) {
+            noza_os.vid_alias[i].thread = NULL;
             break;
         }
-        prev = vp_map;
-        vp_map = vp_map->next;
     }
 
-    src_th->vid = 0;
+    src_th->vid = NOZA_VID_INVALID;
 }
 
 // Noza OS scheduler
+// carve a slab of TCBs from the arena, give each one the next index and put it on the free list
+static bool noza_tcb_slab_grow(void)
+{
+    uint32_t count = NOZA_OS_TASK_LIMIT - noza_os.tcb_count;
+    if (count == 0) {
+        return false;
+    }
+    if (count > NOZA_TCB_SLAB_COUNT) {
+        count = NOZA_TCB_SLAB_COUNT;
+    }
+    thread_t *slab = (thread_t *)noza_arena_alloc(count * sizeof(thread_t));
+    if (slab == NULL) {
+        return false;
+    }
+    memset(slab, 0, count * sizeof(thread_t));
+
+    for (uint32_t i = 0; i < count; i++) {
+        thread_t *th = &slab[i];
+        th->index = (uint16_t)noza_os.tcb_count;
+        noza_os.tcb[noza_os.tcb_count++] = th;
+        th->state_node.value = th;
+        th->sync_node.value = th;
+        th->pi_node.value = th;
+        th->pi_owner = NULL;
+        th->pi_waiters = NULL;
+        th->waiting_queue = NULL;
+        th->event.slot = NOZA_DEADLINE_IDLE;
+        th->event.kind = NOZA_DEADLINE_SLEEP;
+        th->edf.event.slot = NOZA_DEADLINE_IDLE;
+        th->edf.event.kind = NOZA_DEADLINE_EDF;
+        th->port.pending_list.state_id = THREAD_WAITING_READ;
+        th->port.reply_list.state_id = THREAD_WAITING_REPLY;
+        th->join_th = NULL;
+        th->join_target = NULL;
+        th->port_list = NULL;
+        th->stack_area = NULL;
+        th->callid = -1;
+        th->signal_pending = 0;
+        th->signal_mask = 0;
+        noza_os_add_thread(&noza_os.free, th);
+    }
+    return true;
+}
+
 inline static thread_t *noza_thread_alloc()
 {
-    if (noza_os.free.count == 0) {
+    if (noza_os.free.count == 0 && !noza_tcb_slab_grow()) {
         return (thread_t *)0;
     }
 
@@ -936,11 +1776,20 @@ inline static thread_t *noza_thread_alloc()
     th->flags = NONE_DETACH; // reset the thread flags (says, detached)
     th->callid = -1;
     th->trap.state = SYSCALL_DONE;
+    th->trap.word_output = 0;
+    th->port.flags = 0;
     th->signal_pending = 0;
     th->signal_mask = 0;
     th->pending_recv_msg = NULL;
+    th->batch_msgs = NULL;
+    th->async_count = 0;
+    th->event.slack = 0;
+    th->edf.period = 0;
+    memset(&th->acct, 0, sizeof(th->acct));
     th->identity = k_default_identity;
     th->message.identity = k_default_identity;
+    th->core = (uint8_t)platform_get_running_core();
+    th->affinity = NOZA_CORE_MASK_ALL;
     noza_os_insert_vid(th);
     return th;
 }
@@ -951,13 +1800,13 @@ static void noza_release_waiters_from_port(thread_t *th, uint32_t error)
     while (th->port.pending_list.count>0) {
         thread_t *pending = (thread_t *)th->port.pending_list.head->value;
         noza_os_set_return_value1(pending, error);
-        noza_os_change_state(pending, &th->port.pending_list, &noza_os.ready[pending->info.priority]);
+        noza_os_change_state(pending, &th->port.pending_list, noza_ready_target(pending));
     }
 
     while (th->port.reply_list.count>0) {
         thread_t *reply = (thread_t *)th->port.reply_list.head->value;
         noza_os_set_return_value1(reply, error);
-        noza_os_change_state(reply, &th->port.reply_list, &noza_os.ready[reply->info.priority]);
+        noza_os_change_state(reply, &th->port.reply_list, noza_ready_target(reply));
     }
     th->pending_recv_msg = NULL;
 }
@@ -1010,12 +1859,128 @@ static cdl_node_t *cdl_remove(cdl_node_t *head, cdl_node_t *obj)
     }
 }
 
-static inline void noza_wait_queue_init(noza_wait_queue_t *queue)
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// deadline queue: binary min-heap ordered by expiry time, holding every timed
+// kernel event (timers, sleeps, sync timeouts). every entry remembers its heap
+// slot, so cancel is O(log n). callers hold noza_timer_lock.
+//
+static inline bool noza_deadline_before(uint32_t a, uint32_t b)
+{
+    return noza_deadline_heap[a]->when < noza_deadline_heap[b]->when;
+}
+
+static inline void noza_deadline_swap(uint32_t a, uint32_t b)
+{
+    noza_deadline_t *tmp = noza_deadline_heap[a];
+    noza_deadline_heap[a] = noza_deadline_heap[b];
+    noza_deadline_heap[b] = tmp;
+    noza_deadline_heap[a]->slot = a;
+    noza_deadline_heap[b]->slot = b;
+}
+
+static void noza_deadline_sift_up(uint32_t idx)
+{
+    while (idx > 0) {
+        uint32_t parent = (idx - 1) >> 1;
+        if (!noza_deadline_before(idx, parent)) {
+            break;
+        }
+        noza_deadline_swap(idx, parent);
+        idx = parent;
+    }
+}
+
+static void noza_deadline_sift_down(uint32_t idx)
+{
+    for (;;) {
+        uint32_t left = (idx << 1) + 1;
+        uint32_t smallest = idx;
+        if (left < noza_deadline_count && noza_deadline_before(left, smallest)) {
+            smallest = left;
+        }
+        if (left + 1 < noza_deadline_count && noza_deadline_before(left + 1, smallest)) {
+            smallest = left + 1;
+        }
+        if (smallest == idx) {
+            break;
+        }
+        noza_deadline_swap(idx, smallest);
+        idx = smallest;
+    }
+}
+
+static void noza_deadline_cancel(noza_deadline_t *entry)
+{
+    if (entry->slot == NOZA_DEADLINE_IDLE) {
+        return;
+    }
+    uint32_t idx = entry->slot;
+    uint32_t last = --noza_deadline_count;
+    entry->slot = NOZA_DEADLINE_IDLE;
+    if (idx == last) {
+        return;
+    }
+    noza_deadline_t *moved = noza_deadline_heap[last];
+    noza_deadline_heap[idx] = moved;
+    moved->slot = idx;
+    noza_deadline_sift_up(idx);
+    noza_deadline_sift_down(moved->slot);
+}
+
+static void noza_deadline_insert(noza_deadline_t *entry, int64_t when)
+{
+    noza_deadline_cancel(entry);
+    if (noza_deadline_count >= NOZA_DEADLINE_CAPACITY) {
+        kernel_panic("fatal error: noza_deadline_insert: deadline queue is full\n");
+    }
+    entry->when = when;
+    entry->slot = noza_deadline_count;
+    noza_deadline_heap[noza_deadline_count++] = entry;
+    noza_deadline_sift_up(entry->slot);
+}
+
+static inline noza_deadline_t *noza_deadline_peek(void)
+{
+    return noza_deadline_count > 0 ? noza_deadline_heap[0] : NULL;
+}
+
+// tighten bound to the latest time every event due before it still accepts; a
+// subtree whose root is not due before bound cannot tighten it
+static int64_t noza_deadline_window(uint32_t idx, int64_t bound)
+{
+    if (idx >= noza_deadline_count || noza_deadline_heap[idx]->when >= bound) {
+        return bound;
+    }
+    noza_deadline_t *entry = noza_deadline_heap[idx];
+    if (entry->when + entry->slack < bound) {
+        bound = entry->when + entry->slack;
+    }
+    bound = noza_deadline_window((idx << 1) + 1, bound);
+    return noza_deadline_window((idx << 1) + 2, bound);
+}
+
+// one wakeup for all events whose windows overlap the earliest one's
+static inline int64_t noza_deadline_next_wakeup(void)
+{
+    noza_deadline_t *entry = noza_deadline_peek();
+    if (entry == NULL) {
+        return 0;
+    }
+    return noza_deadline_window(0, entry->when + entry->slack);
+}
+
+static void noza_pi_unlink(thread_t *waiter);
+static void noza_futex_release(noza_wait_queue_t *queue);
+
+static inline void noza_wait_queue_init(noza_wait_queue_t *queue, noza_klock_t *lock)
 {
     if (queue == NULL)
         return;
     queue->head = NULL;
     queue->count = 0;
+    queue->lock = lock;
+    queue->release = false;
 }
 
 static inline void noza_wait_queue_enqueue(noza_wait_queue_t *queue, thread_t *thread)
@@ -1041,21 +2006,37 @@ static inline void noza_wait_queue_remove(noza_wait_queue_t *queue, thread_t *th
     if (queue->count > 0)
         queue->count--;
     thread->waiting_queue = NULL;
+    if (thread->pi_owner != NULL) {
+        noza_pi_unlink(thread);
+    }
 #ifdef FUTEX_DEBUG
     FUTEX_LOG("remove thread=%p queue=%p count=%u", thread, queue, queue->count);
 #endif
+    if (queue->count == 0 && queue->release) {
+        noza_futex_release(queue); // the queue is gone, callers must not touch it again
+    }
 }
 
 static inline void noza_wait_queue_cancel_timeout(thread_t *thread)
 {
     if (thread == NULL)
         return;
-    if ((thread->flags & FLAG_WAIT_TIMEOUT) && thread->info.state == THREAD_WAITING_SYNC) {
-        noza_os_remove_thread(&noza_os.sync_sleep, thread);
+    if (thread->flags & FLAG_WAIT_TIMEOUT) {
+        noza_klock_acquire(&noza_timer_lock);
+        noza_deadline_cancel(&thread->event);
+        noza_klock_release(&noza_timer_lock);
         thread->flags &= ~FLAG_WAIT_TIMEOUT;
     }
 }
 
+static inline void noza_wait_queue_wake_thread(noza_wait_queue_t *queue, thread_t *th, int result)
+{
+    noza_wait_queue_remove(queue, th);
+    noza_wait_queue_cancel_timeout(th);
+    noza_os_set_return_value1(th, result);
+    noza_os_add_thread(noza_ready_target(th), th);
+}
+
 static inline uint32_t noza_wait_queue_wake(noza_wait_queue_t *queue, uint32_t count, int result)
 {
     if (queue == NULL || count == 0)
@@ -1070,10 +2051,7 @@ static inline uint32_t noza_wait_queue_wake(noza_wait_queue_t *queue, uint32_t c
 #ifdef FUTEX_DEBUG
         FUTEX_LOG("wake loop head=%p th=%p count=%u queue_count=%u", queue->head, th, count, queue->count);
 #endif
-        noza_wait_queue_remove(queue, th);
-        noza_wait_queue_cancel_timeout(th);
-        noza_os_add_thread(&noza_os.ready[th->info.priority], th);
-        noza_os_set_return_value1(th, result);
+        noza_wait_queue_wake_thread(queue, th, result);
         woke++;
     }
 #ifdef FUTEX_DEBUG
@@ -1103,7 +2081,10 @@ static inline int noza_wait_queue_sleep(noza_wait_queue_t *queue, int64_t timeou
     } else if (timeout_us > 0) {
         running->flags |= FLAG_WAIT_TIMEOUT;
         running->expired_time = platform_get_absolute_time_us() + timeout_us;
-        noza_os_add_thread(&noza_os.sync_sleep, running);
+        running->event.kind = NOZA_DEADLINE_SYNC;
+        noza_klock_acquire(&noza_timer_lock);
+        noza_deadline_insert(&running->event, running->expired_time);
+        noza_klock_release(&noza_timer_lock);
     } else {
         noza_wait_queue_remove(queue, running);
 #ifdef FUTEX_DEBUG
@@ -1120,6 +2101,181 @@ static inline int noza_wait_queue_sleep(noza_wait_queue_t *queue, int64_t timeou
     return 0;
 }
 
+// NSC_WAIT_ANY pollers sleep in noza_poll_waiters. When something of a kind they watch
+// changes, they are woken with EAGAIN and the time they have left, and libc issues the
+// call again to look at the sources; the waker does not evaluate them, it may hold locks
+// ranked after the ones the sources need.
+// does a poller watch the object a kick is about: a futex address or a port, timer or
+// irq id; key 0 stands for every source of the type
+static bool noza_poll_watches(thread_t *th, uint32_t type, uintptr_t key)
+{
+    if (key == 0) {
+        return true;
+    }
+    for (uint32_t i = 0; i < th->poll_count; i++) {
+        noza_wait_source_t *src = &th->poll_sources[i];
+        if (src->type != type) {
+            continue;
+        }
+        uintptr_t watched = (type == NOZA_WAIT_FUTEX) ? (uintptr_t)src->addr : src->id;
+        if (watched == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void noza_poll_kick(uint32_t type, thread_t *only, uintptr_t key)
+{
+    noza_klock_acquire(&noza_timer_lock);
+    uint32_t scan = noza_poll_waiters.count;
+    cdl_node_t *node = noza_poll_waiters.head;
+    while (scan-- > 0) {
+        thread_t *th = node->value;
+        node = node->next;
+        if ((th->poll_kinds & (1u << type)) == 0 || (only != NULL && th != only) ||
+            !noza_poll_watches(th, type, key)) {
+            continue;
+        }
+        int32_t remaining = -1;
+        if (th->flags & FLAG_WAIT_TIMEOUT) {
+            int64_t left = th->expired_time - platform_get_absolute_time_us();
+            remaining = (left > 0) ? (int32_t)left : 0;
+        }
+        noza_wait_queue_remove(&noza_poll_waiters, th);
+        noza_wait_queue_cancel_timeout(th);
+        noza_os_set_return_value2(th, EAGAIN, (uint32_t)remaining);
+        noza_os_add_thread(noza_ready_target(th), th);
+    }
+    noza_klock_release(&noza_timer_lock);
+}
+
+// async requests: a small pool of kernel records, each sent request holds one until the
+// sender collects its completion (or exits)
+static noza_async_t *noza_async_get(uint32_t id)
+{
+    uint32_t index = id & NOZA_PORT_INDEX_MASK;
+    if (!NOZA_ASYNC_IS_ID(id) || index >= NOZA_MAX_ASYNC) {
+        return NULL;
+    }
+    noza_async_t *req = &noza_async[index];
+    if (!req->in_use || noza_async_id(req) != id) {
+        return NULL;
+    }
+    return req;
+}
+
+static noza_async_t *noza_async_alloc(thread_t *owner)
+{
+    for (int i = 0; i < NOZA_MAX_ASYNC; i++) {
+        noza_async_t *req = &noza_async[i];
+        if (!req->in_use) {
+            req->in_use = 1;
+            req->owner = owner;
+            req->server = NULL;
+            req->status = 0;
+            owner->async_count++;
+            return req;
+        }
+    }
+    return NULL;
+}
+
+static void noza_async_free(noza_async_t *req)
+{
+    noza_async_unlink(req);
+    if (req->owner != NULL) {
+        req->owner->async_count--;
+    }
+    req->owner = NULL;
+    req->server = NULL;
+    req->in_use = 0;
+    req->gen++;
+}
+
+static void noza_async_write_result(noza_async_result_t *result, noza_async_t *req)
+{
+    result->tag = req->tag;
+    result->status = req->status;
+    result->reply.to_vid = req->message.pid.reply;
+    result->reply.ptr = req->message.ptr;
+    result->reply.size = req->message.size;
+    memcpy(result->reply.word, req->message.word, sizeof(result->reply.word));
+    result->reply.identity = req->message.identity;
+}
+
+// finish req with status: straight to its sender when it is blocked in NSC_ASYNC_WAIT,
+// otherwise onto the sender's completion queue
+static void noza_async_complete(noza_async_t *req, int32_t status)
+{
+    noza_async_unlink(req);
+    req->server = NULL;
+    req->status = status;
+    if (status != 0) {
+        req->message.ptr = NULL;
+        req->message.size = 0;
+    }
+    thread_t *owner = req->owner;
+    if (owner == NULL) {
+        noza_async_free(req); // nobody left to tell
+    } else if (owner->waiting_queue == &noza_async_waiters) {
+        noza_async_write_result(owner->async_result, req);
+        noza_async_free(req);
+        noza_wait_queue_wake_thread(&noza_async_waiters, owner, 0);
+    } else {
+        noza_async_link(&owner->async_done, req);
+        noza_poll_kick(NOZA_WAIT_ASYNC, owner, 0);
+    }
+}
+
+static bool noza_async_reply(thread_t *server, uint32_t id, void *msg, uint32_t size)
+{
+    noza_async_t *req = noza_async_get(id);
+    if (req == NULL || req->server != server) {
+        return false;
+    }
+    req->message.pid.reply = thread_get_vid(server);
+    req->message.ptr = msg;
+    req->message.size = size;
+    if (size == NOZA_MSG_SHORT) {
+        arch_trap_get_words(server->stack_ptr, req->message.word);
+        req->message.ptr = NULL;
+    }
+    noza_async_complete(req, 0);
+    return true;
+}
+
+// fail every async request still waiting in list
+static void noza_async_release_list(noza_async_list_t *list, int32_t error)
+{
+    while (list->count > 0) {
+        noza_async_complete(list->head->value, error);
+    }
+}
+
+// th exits: its own requests are dropped, the ones it was to serve fail with error
+static void noza_async_release_thread(thread_t *th, int32_t error)
+{
+    for (int i = 0; i < NOZA_MAX_ASYNC; i++) {
+        noza_async_t *req = &noza_async[i];
+        if (!req->in_use) {
+            continue;
+        }
+        if (req->owner == th) {
+            req->owner = NULL;
+            if (req->list != NULL) {
+                noza_async_free(req); // queued or completed, a served one goes on its reply
+                continue;
+            }
+        }
+        if (req->server == th) {
+            noza_async_complete(req, error);
+        }
+    }
+    noza_async_release_list(&th->port.async_list, error);
+    th->async_count = 0;
+}
+
 static inline void noza_signal_interrupt_thread(thread_t *target)
 {
     if (target == NULL)
@@ -1132,17 +2288,17 @@ static inline void noza_signal_interrupt_thread(thread_t *target)
             target->waiting_queue = NULL;
         }
         noza_wait_queue_cancel_timeout(target);
-        noza_os_add_thread(&noza_os.ready[target->info.priority], target);
         noza_os_set_return_value1(target, EINTR);
+        noza_os_add_thread(noza_ready_target(target), target);
         break;
     case THREAD_WAITING_MSG:
-        noza_os_change_state(target, &noza_os.wait, &noza_os.ready[target->info.priority]);
         target->pending_recv_msg = NULL;
         noza_os_set_return_value1(target, EINTR);
+        noza_os_change_state(target, target->port_list, noza_ready_target(target));
         break;
     case THREAD_SLEEP:
-        noza_os_change_state(target, &noza_os.sleep, &noza_os.ready[target->info.priority]);
         noza_os_set_return_value1(target, EINTR);
+        noza_os_change_state(target, &noza_os.sleep, noza_ready_target(target));
         break;
     default:
         break;
@@ -1161,62 +2317,14 @@ static inline void noza_signal_send_thread(thread_t *target, uint32_t signum)
     }
 }
 
-static thread_t *noza_find_port_wait_owner(thread_t *target, thread_list_t **list_out)
-{
-    if (target == NULL || list_out == NULL) {
-        return NULL;
-    }
-
-    for (int i = 0; i < NOZA_OS_TASK_LIMIT; i++) {
-        thread_t *owner = &noza_os.thread[i];
-        if (owner->port.pending_list.count > 0) {
-            thread_t *cursor = (thread_t *)owner->port.pending_list.head->value;
-            for (uint32_t j = 0; j < owner->port.pending_list.count; j++) {
-                if (cursor == target) {
-                    *list_out = &owner->port.pending_list;
-                    return owner;
-                }
-                cursor = (thread_t *)cursor->state_node.next->value;
-            }
-        }
-        if (owner->port.reply_list.count > 0) {
-            thread_t *cursor = (thread_t *)owner->port.reply_list.head->value;
-            for (uint32_t j = 0; j < owner->port.reply_list.count; j++) {
-                if (cursor == target) {
-                    *list_out = &owner->port.reply_list;
-                    return owner;
-                }
-                cursor = (thread_t *)cursor->state_node.next->value;
-            }
-        }
-    }
-    return NULL;
-}
-
-static thread_t *noza_find_join_owner(thread_t *joiner)
-{
-    if (joiner == NULL) {
-        return NULL;
-    }
-
-    for (int i = 0; i < NOZA_OS_TASK_LIMIT; i++) {
-        if (noza_os.thread[i].join_th == joiner) {
-            return &noza_os.thread[i];
-        }
-    }
-    return NULL;
-}
-
 static int noza_detach_blocked_thread(thread_t *target)
 {
-    thread_list_t *wait_list = NULL;
-
     switch (target->info.state) {
     case THREAD_READY:
-        noza_os_remove_thread(&noza_os.ready[target->info.priority], target);
+        noza_os_remove_thread(noza_ready_list(target), target);
         return 0;
     case THREAD_WAITING_MSG:
-        noza_os_remove_thread(&noza_os.wait, target);
+        noza_os_remove_thread(target->port_list, target);
         target->pending_recv_msg = NULL;
         return 0;
     case THREAD_WAITING_SYNC:
@@ -1232,21 +2340,23 @@ static int noza_detach_blocked_thread(thread_t *target)
         return 0;
     case THREAD_WAITING_READ:
     case THREAD_WAITING_REPLY:
-        if (noza_find_port_wait_owner(target, &wait_list) == NULL || wait_list == NULL) {
+        if (target->port_list == NULL) {
             return ESRCH;
         }
-        noza_os_remove_thread(wait_list, target);
+        noza_os_remove_thread(target->port_list, target);
         return 0;
-    case THREAD_PENDING_JOIN: {
-        thread_t *owner = noza_find_join_owner(target);
-        if (owner != NULL) {
-            owner->join_th = NULL;
+    case THREAD_PENDING_JOIN:
+        if (target->join_target != NULL) {
+            target->join_target->join_th = NULL;
+            target->join_target = NULL;
         }
         return 0;
-    }
     case THREAD_STOPPED:
         noza_os_remove_thread(&noza_os.stopped, target);
         return 0;
+    case THREAD_THROTTLED:
+        noza_os_remove_thread(&noza_os.throttled, target);
+        return 0;
     case THREAD_RUNNING:
         if (target != noza_os_get_running_thread()) {
             return EBUSY;
@@ -1263,19 +2373,28 @@ static int noza_detach_blocked_thread(thread_t *target)
 static void noza_release_join_waiter(thread_t *target)
 {
     if (target->join_th != NULL) {
-        noza_os_add_thread(&noza_os.ready[target->join_th->info.priority], target->join_th);
-        noza_os_set_return_value2(target->join_th, 0, target->exit_code);
+        thread_t *joiner = target->join_th;
+        noza_os_set_return_value2(joiner, 0, target->exit_code);
+        joiner->join_target = NULL;
         target->join_th = NULL;
+        noza_os_add_thread(noza_ready_target(joiner), joiner);
     }
 }
 
+static void noza_futex_release_pi_owned(thread_t *owner);
+
 static void noza_finalize_thread_exit(thread_t *target)
 {
+    // callers donating to the port go first, the PI waiters left are all futex waiters
+    noza_release_waiters_from_port(target, EINTR);
+    noza_port_release_owned(target);
+    noza_async_release_thread(target, EINTR);
+    noza_futex_release_pi_owned(target);
+    noza_edf_release(target);
     target->info.port_state = PORT_WAIT_LISTEN;
     target->pending_recv_msg = NULL;
     target->waiting_queue = NULL;
     target->expired_time = 0;
-    noza_release_waiters_from_port(target, EINTR);
 
     if (target->join_th == NULL) {
         if (target->flags & FLAG_DETACH) {
@@ -1308,55 +2427,319 @@ static int noza_terminate_thread(thread_t *target, uint32_t exit_code)
     return 0;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// priority inheritance
+//
+// A thread blocked on a PI futex is linked into its owner's pi_waiters list, and the
+// owner runs at the best priority among its waiters. Priorities and the pi lists are
+// guarded by noza_sched_lock, so boosts can propagate along a chain of owners without
+// touching the futex buckets involved.
+//
+#define NOZA_PI_CHAIN_LIMIT     8           // bound on boost propagation through nested owners
+
+// base priority raised to the best PI waiter; caller holds noza_sched_lock
+static uint32_t noza_pi_effective_priority(thread_t *th)
+{
+    uint32_t priority = th->info.base_priority;
+    cdl_node_t *node = th->pi_waiters;
+    if (node != NULL) {
+        do {
+            thread_t *waiter = (thread_t *)node->value;
+            if (waiter->info.priority < priority) {
+                priority = waiter->info.priority;
+            }
+            node = node->next;
+        } while (node != th->pi_waiters);
+    }
+    return priority;
+}
+
+// move a thread to a new priority, requeueing it when it sits in a ready queue
+static void noza_thread_apply_priority(thread_t *th, uint32_t priority)
+{
+    if (th->info.state == THREAD_READY) {
+        noza_os_remove_thread(noza_ready_list(th), th);
+        th->info.priority = priority;
+        noza_os_add_thread(noza_ready_target(th), th);
+    } else {
+        th->info.priority = priority;
+    }
+}
+
+// recompute th and every owner it is blocked behind
+static void noza_pi_propagate(thread_t *th)
+{
+    noza_klock_acquire(&noza_sched_lock);
+    for (int depth = 0; th != NULL && depth < NOZA_PI_CHAIN_LIMIT; depth++) {
+        uint32_t priority = noza_pi_effective_priority(th);
+        if (priority == th->info.priority) {
+            break;
+        }
+        noza_thread_apply_priority(th, priority);
+        th = th->pi_owner;
+    }
+    noza_klock_release(&noza_sched_lock);
+}
+
+static void noza_pi_link(thread_t *waiter, thread_t *owner)
+{
+    noza_klock_acquire(&noza_sched_lock);
+    waiter->pi_owner = owner;
+    owner->pi_waiters = cdl_add(owner->pi_waiters, &waiter->pi_node);
+    noza_pi_propagate(owner);
+    noza_klock_release(&noza_sched_lock);
+}
+
+static void noza_pi_unlink(thread_t *waiter)
+{
+    noza_klock_acquire(&noza_sched_lock);
+    thread_t *owner = waiter->pi_owner;
+    if (owner != NULL) {
+        owner->pi_waiters = cdl_remove(owner->pi_waiters, &waiter->pi_node);
+        waiter->pi_owner = NULL;
+        noza_pi_propagate(owner);
+    }
+    noza_klock_release(&noza_sched_lock);
+}
+
+// hand the waiters of futex key from its old owner to the new one
+static void noza_pi_transfer(thread_t *from, thread_t *to, uintptr_t key)
+{
+    noza_klock_acquire(&noza_sched_lock);
+    cdl_node_t *node = from->pi_waiters;
+    cdl_node_t *last = node ? node->prev : NULL;
+    while (node != NULL) {
+        thread_t *waiter = (thread_t *)node->value;
+        cdl_node_t *next = node->next;
+        bool done = (node == last);
+        if (waiter != to && waiter->futex_key == key) {
+            from->pi_waiters = cdl_remove(from->pi_waiters, node);
+            to->pi_waiters = cdl_add(to->pi_waiters, node);
+            waiter->pi_owner = to;
+        }
+        if (done) {
+            break;
+        }
+        node = next;
+    }
+    noza_pi_propagate(to);
+    noza_pi_propagate(from);
+    noza_klock_release(&noza_sched_lock);
+}
+
 static inline uint32_t noza_futex_hash(uintptr_t key)
 {
     key ^= key >> 4;
     key ^= key >> 9;
     key ^= key >> 16;
-    return key & (NOZA_FUTEX_SLOT_COUNT - 1);
+    return key & (NOZA_FUTEX_BUCKET_COUNT - 1);
+}
+
+static inline noza_klock_t *noza_futex_bucket_lock(uintptr_t key)
+{
+    return &noza_futex_lock[noza_futex_hash(key) % NOZA_FUTEX_LOCK_COUNT];
+}
+
+// entry of key, NULL if nothing waits on it; caller holds noza_futex_bucket_lock(key)
+static noza_futex_entry_t *noza_futex_lookup(uintptr_t key)
+{
+    noza_futex_entry_t *entry = noza_futex_buckets[noza_futex_hash(key)];
+    while (entry != NULL && entry->key != key) {
+        entry = entry->next;
+    }
+    return entry;
 }
 
-static noza_wait_queue_t *noza_futex_get_queue(void *addr, bool create)
+// entry of key, taking one from the pool if the address has no waiters yet; the pool
+// holds one entry per thread, so it only runs dry if the accounting is broken.
+// caller holds noza_futex_bucket_lock(key) and must queue a waiter on the result
+static noza_futex_entry_t *noza_futex_get(uintptr_t key)
 {
-    if (addr == NULL)
+    noza_futex_entry_t *entry = noza_futex_lookup(key);
+    if (entry != NULL) {
+        return entry;
+    }
+    noza_klock_acquire(&noza_futex_pool_lock);
+    entry = noza_futex_free;
+    if (entry != NULL) {
+        noza_futex_free = entry->next;
+    }
+    noza_klock_release(&noza_futex_pool_lock);
+    if (entry == NULL) {
         return NULL;
+    }
 
-    uintptr_t key = (uintptr_t)addr;
-    uint32_t start = noza_futex_hash(key);
+    uint32_t hash = noza_futex_hash(key);
+    noza_wait_queue_init(&entry->queue, noza_futex_bucket_lock(key));
+    entry->queue.release = true;
+    entry->key = key;
+    entry->next = noza_futex_buckets[hash];
+    noza_futex_buckets[hash] = entry;
+    return entry;
+}
 
-    for (uint32_t i = 0; i < NOZA_FUTEX_SLOT_COUNT; i++) {
-        uint32_t idx = (start + i) & (NOZA_FUTEX_SLOT_COUNT - 1);
-        noza_futex_slot_t *slot = &noza_futex_slots[idx];
-        if (slot->in_use && slot->key == key) {
-#ifdef FUTEX_DEBUG
-            FUTEX_LOG("reuse slot idx=%u addr=%p queue=%p count=%u", idx, addr, &slot->queue, slot->queue.count);
-#endif
-            return &slot->queue;
+// the last waiter left an entry queue: unchain it and hand it back to the pool;
+// called from noza_wait_queue_remove with the entry's stripe lock held
+static void noza_futex_release(noza_wait_queue_t *queue)
+{
+    noza_futex_entry_t *entry = (noza_futex_entry_t *)queue;
+    noza_futex_entry_t **link = &noza_futex_buckets[noza_futex_hash(entry->key)];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    entry->queue.release = false;
+
+    noza_klock_acquire(&noza_futex_pool_lock);
+    entry->next = noza_futex_free;
+    noza_futex_free = entry;
+    noza_klock_release(&noza_futex_pool_lock);
+}
+
+// the most urgent waiter of entry whose bitset intersects bitset, FIFO among equals;
+// NULL if none qualifies
+static thread_t *noza_futex_best_waiter(noza_futex_entry_t *entry, uint32_t bitset)
+{
+    thread_t *best = NULL;
+    uint32_t scan = entry->queue.count;
+    cdl_node_t *node = entry->queue.head;
+    while (scan-- > 0) {
+        thread_t *th = (thread_t *)node->value;
+        node = node->next;
+        if ((th->futex_bitset & bitset) == 0)
+            continue;
+        if (best == NULL || th->info.priority < best->info.priority) {
+            best = th;
         }
-        if (!slot->in_use && create) {
-            slot->in_use = true;
-            slot->key = key;
-            noza_wait_queue_init(&slot->queue);
-#ifdef FUTEX_DEBUG
-            FUTEX_LOG("create slot idx=%u addr=%p queue=%p", idx, addr, &slot->queue);
-#endif
-            return &slot->queue;
+    }
+    return best;
+}
+
+// wake up to count waiters of key whose bitset intersects bitset, most urgent first;
+// the entry is released once its last waiter is gone
+static uint32_t noza_futex_wake_key(uintptr_t key, uint32_t count, uint32_t bitset, int result)
+{
+    noza_futex_entry_t *entry = noza_futex_lookup(key);
+    if (entry == NULL) {
+        return 0;
+    }
+    uint32_t woke = 0;
+    uint32_t left = entry->queue.count;
+    while (left > 0 && woke < count) {
+        thread_t *th = noza_futex_best_waiter(entry, bitset);
+        if (th == NULL)
+            break;
+        TRACE_EVENT(NOZA_TRACE_FUTEX_WAKE, thread_get_vid(th), key, 0);
+        noza_wait_queue_wake_thread(&entry->queue, th, result);
+        woke++;
+        left--;
+    }
+    return woke;
+}
+
+// wake nr_wake waiters of key, then move up to nr_requeue of the rest onto key2
+// without waking them, most urgent first in both steps; caller holds both bucket locks
+static uint32_t noza_futex_requeue_key(uintptr_t key, uintptr_t key2, uint32_t nr_wake, uint32_t nr_requeue)
+{
+    noza_futex_entry_t *from = noza_futex_lookup(key);
+    noza_futex_entry_t *to = NULL;
+    if (from == NULL) {
+        return 0;
+    }
+    uint32_t woke = 0;
+    uint32_t moved = 0;
+    uint32_t left = from->queue.count; // from is released with its last waiter
+    while (left > 0 && woke < nr_wake) {
+        noza_wait_queue_wake_thread(&from->queue, noza_futex_best_waiter(from, NOZA_FUTEX_BITSET_ANY), 0);
+        woke++;
+        left--;
+    }
+    if (key2 == key) {
+        return woke + ((left < nr_requeue) ? left : nr_requeue); // already waiting on the target
+    }
+    while (left > 0 && moved < nr_requeue) {
+        if (to == NULL && (to = noza_futex_get(key2)) == NULL) {
+            break;
         }
-        if (!slot->in_use && !create) {
-            return NULL;
+        thread_t *th = noza_futex_best_waiter(from, NOZA_FUTEX_BITSET_ANY);
+        noza_wait_queue_remove(&from->queue, th);
+        th->futex_key = key2;
+        noza_wait_queue_enqueue(&to->queue, th);
+        moved++;
+        left--;
+    }
+    return woke + moved;
+}
+
+// two-address operations take both stripes in ascending order
+static void noza_futex_lock_pair(uintptr_t key, uintptr_t key2)
+{
+    noza_klock_t *first = noza_futex_bucket_lock(key);
+    noza_klock_t *second = noza_futex_bucket_lock(key2);
+    if (second < first) {
+        noza_klock_t *tmp = first;
+        first = second;
+        second = tmp;
+    }
+    noza_klock_acquire(first);
+    noza_klock_acquire(second);
+}
+
+static void noza_futex_unlock_pair(uintptr_t key, uintptr_t key2)
+{
+    noza_klock_release(noza_futex_bucket_lock(key2));
+    noza_klock_release(noza_futex_bucket_lock(key));
+}
+
+// NOZA_FUTEX_WAKE_OP: apply the encoded op to *addr2 and report the comparison
+// against the old value; the bucket lock of addr2 is the only writer inside the kernel
+static int noza_futex_apply_op(uint32_t *addr2, uint32_t encoded, bool *wake2)
+{
+    uint32_t op = (encoded >> 28) & 0xf;
+    uint32_t cmp = (encoded >> 24) & 0xf;
+    int32_t oparg = (int32_t)(encoded << 8) >> 20;
+    int32_t cmparg = (int32_t)(encoded << 20) >> 20;
+
+    if (op & NOZA_FUTEX_OP_OPARG_SHIFT) {
+        op &= ~NOZA_FUTEX_OP_OPARG_SHIFT;
+        oparg = (int32_t)(1u << (oparg & 31));
+    }
+    if (op > NOZA_FUTEX_OP_XOR || cmp > NOZA_FUTEX_OP_CMP_GE)
+        return EINVAL;
+
+    // user space updates the word with __atomic_* and never takes the bucket lock, so the
+    // update is a compare-and-swap loop; on rp2040 both sides go through the same SDK
+    // atomic helpers and their spin lock
+    int32_t *word = (int32_t *)addr2;
+    int32_t old = __atomic_load_n(word, __ATOMIC_RELAXED);
+    int32_t val;
+    do {
+        switch (op) {
+            case NOZA_FUTEX_OP_SET:  val = oparg; break;
+            case NOZA_FUTEX_OP_ADD:  val = old + oparg; break;
+            case NOZA_FUTEX_OP_OR:   val = old | oparg; break;
+            case NOZA_FUTEX_OP_ANDN: val = old & ~oparg; break;
+            default:                 val = old ^ oparg; break;
         }
+    } while (!__atomic_compare_exchange_n(word, &old, val, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+    switch (cmp) {
+        case NOZA_FUTEX_OP_CMP_EQ: *wake2 = (old == cmparg); break;
+        case NOZA_FUTEX_OP_CMP_NE: *wake2 = (old != cmparg); break;
+        case NOZA_FUTEX_OP_CMP_LT: *wake2 = (old < cmparg); break;
+        case NOZA_FUTEX_OP_CMP_LE: *wake2 = (old <= cmparg); break;
+        case NOZA_FUTEX_OP_CMP_GT: *wake2 = (old > cmparg); break;
+        case NOZA_FUTEX_OP_CMP_GE: *wake2 = (old >= cmparg); break;
     }
-#ifdef FUTEX_DEBUG
-    FUTEX_LOG("futex slot full for addr=%p", addr);
-#endif
-    return NULL;
+    return 0;
 }
 
 static inline void noza_timer_remove(noza_timer_t *timer)
 {
-    if (timer == NULL || !timer->armed || noza_timer_head == NULL)
+    if (timer == NULL || !timer->armed)
         return;
-    noza_timer_head = cdl_remove(noza_timer_head, &timer->node);
+    noza_deadline_cancel(&timer->event);
     timer->armed = false;
     TIMER_LOG("remove id=%u owner=%u deadline=%" PRId64, timer->id, timer->owner_vid, timer->deadline);
 }
@@ -1366,51 +2749,19 @@ static inline void noza_timer_insert(noza_timer_t *timer)
     if (timer == NULL)
         return;
 
-    cdl_node_t *node = &timer->node;
-    node->value = timer;
-    if (noza_timer_head == NULL) {
-        node->next = node;
-        node->prev = node;
-        noza_timer_head = node;
-        timer->armed = true;
-        TIMER_LOG("insert head id=%u owner=%u deadline=%" PRId64, timer->id, timer->owner_vid, timer->deadline);
-        return;
-    }
-
-    cdl_node_t *cursor = noza_timer_head;
-    do {
-        noza_timer_t *cur = (noza_timer_t *)cursor->value;
-        if (cur->deadline > timer->deadline) {
-            node->next = cursor;
-            node->prev = cursor->prev;
-            cursor->prev->next = node;
-            cursor->prev = node;
-            if (cursor == noza_timer_head) {
-                noza_timer_head = node;
-            }
-            timer->armed = true;
-            TIMER_LOG("insert before id=%u owner=%u deadline=%" PRId64, timer->id, timer->owner_vid, timer->deadline);
-            return;
-        }
-        cursor = cursor->next;
-    } while (cursor != noza_timer_head);
-
-    node->next = noza_timer_head;
-    node->prev = noza_timer_head->prev;
-    noza_timer_head->prev->next = node;
-    noza_timer_head->prev = node;
+    noza_deadline_insert(&timer->event, timer->deadline);
     timer->armed = true;
-    TIMER_LOG("insert tail id=%u owner=%u deadline=%" PRId64, timer->id, timer->owner_vid, timer->deadline);
+    TIMER_LOG("insert id=%u owner=%u deadline=%" PRId64, timer->id, timer->owner_vid, timer->deadline);
 }
 
+// timer ids carry their slot index: id = seq * NOZA_MAX_TIMERS + index
 static inline noza_timer_t *noza_timer_lookup(uint32_t id)
 {
-    for (int i = 0; i < NOZA_MAX_TIMERS; i++) {
-        if (noza_timers[i].in_use && noza_timers[i].id == id) {
-            TIMER_LOG("lookup id=%u owner=%u armed=%d pending=%u", id, noza_timers[i].owner_vid,
-                noza_timers[i].armed, noza_timers[i].pending_fires);
-            return &noza_timers[i];
-        }
+    noza_timer_t *timer = &noza_timers[id % NOZA_MAX_TIMERS];
+    if (timer->in_use && timer->id == id) {
+        TIMER_LOG("lookup id=%u owner=%u armed=%d pending=%u", id, timer->owner_vid,
+            timer->armed, timer->pending_fires);
+        return timer;
     }
     TIMER_LOG("lookup failed id=%u", id);
     return NULL;
@@ -1418,27 +2769,31 @@ static inline noza_timer_t *noza_timer_lookup(uint32_t id)
 
 static inline noza_timer_t *noza_timer_alloc(uint32_t owner_vid)
 {
-    for (int i = 0; i < NOZA_MAX_TIMERS; i++) {
-        if (!noza_timers[i].in_use) {
-            noza_timers[i].in_use = true;
-            noza_timers[i].armed = false;
-            noza_timers[i].owner_vid = owner_vid;
-            noza_timers[i].pending_fires = 0;
-            noza_timers[i].deadline = 0;
-            noza_timers[i].period_us = 0;
-            noza_timers[i].flags = 0;
-            noza_timers[i].id = noza_timer_seq++;
-            if (noza_timer_seq == 0) {
-                noza_timer_seq = 1;
-            }
-            noza_wait_queue_init(&noza_timers[i].wait_queue);
-            noza_timers[i].node.value = &noza_timers[i];
-            TIMER_LOG("alloc idx=%d id=%u owner=%u", i, noza_timers[i].id, owner_vid);
-            return &noza_timers[i];
-        }
+    noza_timer_t *timer = noza_timer_free;
+    if (timer == NULL) {
+        TIMER_LOG("alloc failed owner=%u", owner_vid);
+        return NULL;
     }
-    TIMER_LOG("alloc failed owner=%u", owner_vid);
-    return NULL;
+    noza_timer_free = timer->next_free;
+    timer->next_free = NULL;
+
+    uint32_t index = (uint32_t)(timer - noza_timers);
+    timer->in_use = true;
+    timer->armed = false;
+    timer->owner_vid = owner_vid;
+    timer->pending_fires = 0;
+    timer->deadline = 0;
+    timer->period_us = 0;
+    timer->flags = 0;
+    timer->event.slack = 0;
+    timer->id = noza_timer_seq * NOZA_MAX_TIMERS + index;
+    noza_timer_seq++;
+    if (noza_timer_seq >= UINT32_MAX / NOZA_MAX_TIMERS) {
+        noza_timer_seq = 1; // wrap but keep id 0 unused
+    }
+    noza_wait_queue_init(&timer->wait_queue, &noza_timer_lock);
+    TIMER_LOG("alloc idx=%u id=%u owner=%u", index, timer->id, owner_vid);
+    return timer;
 }
 
 static inline void noza_timer_release(noza_timer_t *timer)
@@ -1449,13 +2804,15 @@ static inline void noza_timer_release(noza_timer_t *timer)
     if (timer->wait_queue.count > 0) {
         noza_wait_queue_wake(&timer->wait_queue, timer->wait_queue.count, ECANCELED);
     }
-    noza_wait_queue_init(&timer->wait_queue);
+    noza_wait_queue_init(&timer->wait_queue, &noza_timer_lock);
     timer->in_use = false;
     timer->pending_fires = 0;
     timer->owner_vid = 0;
     timer->flags = 0;
     timer->period_us = 0;
     timer->deadline = 0;
+    timer->next_free = noza_timer_free;
+    noza_timer_free = timer;
     TIMER_LOG("release id=%u", timer->id);
 }
 
@@ -1467,6 +2824,10 @@ static inline void noza_timer_fire(noza_timer_t *timer)
         noza_wait_queue_wake(&timer->wait_queue, 1, 0);
     } else {
         timer->pending_fires++;
+        thread_t *owner = get_thread_by_vid(timer->owner_vid); // only the owner may watch it
+        if (owner != NULL) {
+            noza_poll_kick(NOZA_WAIT_TIMER, owner, timer->id);
+        }
     }
     TIMER_LOG("fire id=%u owner=%u pending=%u armed=%d flags=0x%x", timer->id, timer->owner_vid,
         timer->pending_fires, timer->armed, timer->flags);
@@ -1479,92 +2840,216 @@ static inline void noza_timer_fire(noza_timer_t *timer)
     }
 }
 
-static inline void noza_timer_tick(int64_t now)
+// ready bitmap: priority 0 (highest) is the MSB, so clz gives the best ready level
+#define READY_BIT(priority)     (0x80000000u >> (priority))
+
+#define READY_CORE(list)        ((uint32_t)((list) - &noza_os.ready[0][0]) / NOZA_OS_PRIORITY_LIMIT)
+#define READY_LEVEL(list)       ((uint32_t)((list) - &noza_os.ready[0][0]) % NOZA_OS_PRIORITY_LIMIT)
+
+#define EDF_IS_READY_LIST(list) ((uintptr_t)(list) - (uintptr_t)noza_os.edf_ready < sizeof(noza_os.edf_ready))
+#define EDF_CORE(list)          ((uint32_t)((list) - noza_os.edf_ready))
+
+static inline bool noza_edf_thread(thread_t *th)
+{
+    return th->edf.period != 0;
+}
+
+// a and b both in the deadline class: does a run first
+static inline bool noza_edf_before(thread_t *a, thread_t *b)
 {
-    while (noza_timer_head) {
-        noza_timer_t *timer = (noza_timer_t *)noza_timer_head->value;
-        if (timer->deadline > now) {
-            break;
+    return a->edf.deadline < b->edf.deadline;
+}
+
+// deadline threads have no bitmap bit: their queue is looked at before the bands
+static inline void noza_edf_ready_kick(thread_list_t *list, thread_t *thread)
+{
+#if NOZA_OS_NUM_CORES > 1
+    uint32_t core = EDF_CORE(list);
+    if (core != platform_get_running_core()) {
+        thread_t *busy = noza_os.running[core];
+        if (busy == NULL || !noza_edf_thread(busy) || noza_edf_before(thread, busy)) {
+            platform_request_schedule((int)core);
         }
-        TIMER_LOG("tick now=%" PRId64 " firing id=%u deadline=%" PRId64, now, timer->id, timer->deadline);
-        noza_timer_remove(timer);
-        noza_timer_fire(timer);
     }
+#else
+    (void)list;
+    (void)thread;
+#endif
 }
 
-static void noza_os_add_thread_by_expired_time(thread_list_t *list, thread_t *thread)
+static inline void noza_ready_bitmap_set(thread_list_t *list)
 {
-    // find a proper place to insert the thread
-    int64_t expired_time = thread->expired_time;
-    cdl_node_t *node = list->head;
-    if (node == NULL) {
-        // 0 element
-        list->head = &thread->state_node;
-        thread->state_node.next = &thread->state_node;
-        thread->state_node.prev = &thread->state_node;
-    } else if (node->next == node) {
-        // 1 element
-        node->next = &thread->state_node;
-        node->prev = &thread->state_node;
-        thread->state_node.next = node;
-        thread->state_node.prev = node;
-        if (((thread_t *)node->value)->expired_time > expired_time) {
-            list->head = &thread->state_node;
+    uint32_t core = READY_CORE(list);
+    uint32_t level = READY_LEVEL(list);
+    noza_os.ready_bitmap[core] |= READY_BIT(level);
+#if NOZA_OS_NUM_CORES > 1
+    // kick the owning core when the new thread should preempt (or wake) it
+    if (core != platform_get_running_core()) {
+        thread_t *busy = noza_os.running[core];
+        if (busy == NULL || busy->info.priority > level) {
+            platform_request_schedule((int)core);
         }
-    } else {
-        // more than 2 elements
-        cdl_node_t *tail = node->prev;
-        while (node != tail) {
-            if (((thread_t *)node->value)->expired_time > expired_time) {
-                // insert before node
-                thread->state_node.next = node;
-                thread->state_node.prev = node->prev;
-                node->prev->next = &thread->state_node;
-                node->prev = &thread->state_node;
-                if (node == list->head) {
-                    list->head = &thread->state_node;
-                }
+    }
+#endif
+}
+
+static inline void noza_ready_bitmap_clear(thread_list_t *list)
+{
+    if (list->count == 0 && !EDF_IS_READY_LIST(list)) {
+        noza_os.ready_bitmap[READY_CORE(list)] &= ~READY_BIT(READY_LEVEL(list));
+    }
+}
+
+// the ready queue currently holding th (valid while th is THREAD_READY)
+static thread_list_t *noza_ready_list(thread_t *th)
+{
+    if (noza_edf_thread(th)) {
+        return &noza_os.edf_ready[th->core];
+    }
+    return &noza_os.ready[th->core][th->info.priority];
+}
+
+// choose the ready queue for a thread about to become runnable:
+// stay on the last core for cache warmth unless affinity forbids it,
+// or that core is busy with an equal or better thread while an allowed core idles
+static thread_list_t *noza_ready_target(thread_t *th)
+{
+    if (noza_edf_thread(th)) {
+        // deadline threads stay on the core that admitted them
+        if (th->edf.remaining <= 0) {
+            return &noza_os.throttled;
+        }
+        th->core = th->edf.core;
+        return &noza_os.edf_ready[th->edf.core];
+    }
+
+    uint32_t core = th->core;
+#if NOZA_OS_NUM_CORES > 1
+    uint32_t allowed = th->affinity & NOZA_CORE_MASK_ALL;
+    if ((allowed & (1u << core)) == 0) {
+        core = __builtin_ctz(allowed);
+    }
+    thread_t *busy = noza_os.running[core];
+    if (busy != NULL && busy != th && busy->info.priority <= th->info.priority) {
+        for (uint32_t c = 0; c < NOZA_OS_NUM_CORES; c++) {
+            if ((allowed & (1u << c)) && noza_os.running[c] == NULL && noza_os.ready_bitmap[c] == 0) {
+                core = c;
                 break;
             }
-            node = node->next;
-        }
-        if (node == tail) {
-            list->head = cdl_add(list->head, &thread->state_node);
         }
     }
+    th->core = (uint8_t)core;
+#endif
+    return &noza_os.ready[core][th->info.priority];
+}
+
+// the server whose pending or reply list this is
+static inline thread_t *noza_port_owner(thread_list_t *list)
+{
+    if ((uintptr_t)list - (uintptr_t)noza_ports < sizeof(noza_ports)) {
+        return NULL; // a port object queue, nobody serves these callers yet
+    }
+    if (list->state_id == THREAD_WAITING_READ) {
+        return (thread_t *)((char *)list - offsetof(thread_t, port.pending_list));
+    }
+    return (thread_t *)((char *)list - offsetof(thread_t, port.reply_list));
+}
+
+// deadline threads queue by absolute deadline, FIFO among equals
+static cdl_node_t *noza_edf_insert_by_deadline(cdl_node_t *head, thread_t *thread)
+{
+    cdl_node_t *node = head;
+    if (node != NULL) {
+        do {
+            if (noza_edf_before(thread, (thread_t *)node->value)) {
+                cdl_add(node, &thread->state_node); // link in front of node
+                return node == head ? &thread->state_node : head;
+            }
+            node = node->next;
+        } while (node != head);
+    }
+    return cdl_add(head, &thread->state_node);
+}
 
-#if 0
-    // check the order of this list
-    node = list->head;
-    if (node) {
-        printk("now=%" PRId64 "\n", platform_get_absolute_time_us());
-        printk("** head diff = %" PRId64 "\n", ((thread_t *)node->value)->expired_time - platform_get_absolute_time_us());
-        cdl_node_t *tail = node->prev;
-        while (node != tail) {
-            if (((thread_t *)node->value)->expired_time > ((thread_t *)node->next->value)->expired_time) {
-                kernel_panic("fatal error: noza_os_add_thread_by_expired_time: list is not sorted\n");
+// callers queue in priority order, FIFO among equals, so recv always takes the most
+// urgent one; a caller's position is fixed when it is queued
+static cdl_node_t *noza_port_insert_by_priority(cdl_node_t *head, thread_t *thread)
+{
+    cdl_node_t *node = head;
+    if (node != NULL) {
+        do {
+            if (thread->info.priority < ((thread_t *)node->value)->info.priority) {
+                cdl_add(node, &thread->state_node); // link in front of node
+                return node == head ? &thread->state_node : head;
             }
-            //printk("expired_time=%" PRId64 ", %" PRId64 "\n", ((thread_t *)node->value)->expired_time, ((thread_t *)node->next->value)->expired_time);
             node = node->next;
-        }
+        } while (node != head);
+    }
+    return cdl_add(head, &thread->state_node);
+}
+
+// a server with NOZA_PORT_PRIORITY_DONATION runs at the priority of its most urgent caller,
+// queued or being served, until it replies; donations ride on the PI waiter links
+static inline void noza_port_donate(thread_t *client, thread_list_t *list)
+{
+    thread_t *server = noza_port_owner(list);
+    if (server != NULL && (server->port.flags & NOZA_PORT_PRIORITY_DONATION)) {
+        noza_pi_link(client, server);
     }
-#endif
 }
 
+// ready queues belong to the sched domain and the sleep list to the timer domain,
+// every other list is covered by the domain lock its caller already holds
+static inline noza_klock_t *noza_list_lock(thread_list_t *list)
+{
+    if (list->state_id == THREAD_READY || list->state_id == THREAD_THROTTLED) {
+        return &noza_sched_lock;
+    } else if (list->state_id == THREAD_SLEEP) {
+        return &noza_timer_lock;
+    }
+    return NULL;
+}
+
+// a thread becomes visible to other cores once it is on a ready queue:
+// write its syscall results before adding it
 static void noza_os_add_thread(thread_list_t *list, thread_t *thread)
 {
-    if (list->state_id == THREAD_SLEEP) {
-        noza_os_add_thread_by_expired_time(list, thread);
+    noza_klock_t *lock = noza_list_lock(list);
+    if (lock)
+        noza_klock_acquire(lock);
+    if (list == &noza_os.throttled && thread->edf.remaining > 0) {
+        list = noza_ready_target(thread); // replenished since the caller picked the list
+    }
+    if (list->state_id == THREAD_WAITING_READ) {
+        list->head = noza_port_insert_by_priority(list->head, thread);
+    } else if (EDF_IS_READY_LIST(list)) {
+        list->head = noza_edf_insert_by_deadline(list->head, thread);
     } else {
         list->head = cdl_add(list->head, &thread->state_node);
     }
-
     list->count++;
     thread->info.state = list->state_id;
+    if (EDF_IS_READY_LIST(list)) {
+        noza_edf_ready_kick(list, thread);
+    } else if (list->state_id == THREAD_READY) {
+        noza_ready_bitmap_set(list);
+    } else if (list->state_id == THREAD_SLEEP) {
+        thread->event.kind = NOZA_DEADLINE_SLEEP;
+        noza_deadline_insert(&thread->event, thread->expired_time);
+    } else if (list->state_id == THREAD_WAITING_READ || list->state_id == THREAD_WAITING_REPLY) {
+        thread->port_list = list;
+        noza_port_donate(thread, list);
+    } else if (list->state_id == THREAD_WAITING_MSG) {
+        thread->port_list = list;
+    }
 
     if (list->state_id == THREAD_FREE) {
         noza_os_remove_vid(thread);
+        noza_arena_release(thread->stack_area); // the TCB stays in its slab for reuse
+        thread->stack_area = NULL;
     }
+    if (lock)
+        noza_klock_release(lock);
 }
 
 static void noza_os_remove_thread(thread_list_t *list, thread_t *thread)
@@ -1574,8 +3059,140 @@ static void noza_os_remove_thread(thread_list_t *list, thread_t *thread)
             state_to_str(list->state_id), state_to_str(thread->info.state));
     }
 
+    noza_klock_t *lock = noza_list_lock(list);
+    if (lock)
+        noza_klock_acquire(lock);
     list->head = cdl_remove(list->head, &thread->state_node);
     list->count--;
+    if (list->state_id == THREAD_READY) {
+        noza_ready_bitmap_clear(list);
+    } else if (list->state_id == THREAD_SLEEP) {
+        noza_deadline_cancel(&thread->event);
+    } else if (list->state_id == THREAD_WAITING_READ || list->state_id == THREAD_WAITING_REPLY) {
+        thread->port_list = NULL;
+        if (thread->pi_owner != NULL) {
+            noza_pi_unlink(thread); // withdraw the donation to the server
+        }
+    } else if (list->state_id == THREAD_WAITING_MSG) {
+        thread->port_list = NULL;
+    }
+    if (lock)
+        noza_klock_release(lock);
+}
+
+//////////////////////////////////////////////////////////////
+//
+// deadline scheduling class
+//
+// partitioned EDF: a thread is admitted to one core while the runtime/deadline densities
+// there stay under NOZA_EDF_UTIL_LIMIT, then queues on that core's edf_ready list
+// ahead of every priority band. The running thread is charged in the scheduler
+// loop and throttled once its runtime is gone; its replenishment event in the
+// deadline queue opens the next period. remaining is written under noza_sched_lock.
+//
+#define NOZA_EDF_PPM            1000000u
+
+// the list th is queued on in the ready or throttled state, NULL otherwise
+static inline thread_list_t *noza_edf_queued_list(thread_t *th)
+{
+    if (th->info.state == THREAD_READY) {
+        return noza_ready_list(th);
+    } else if (th->info.state == THREAD_THROTTLED) {
+        return &noza_os.throttled;
+    }
+    return NULL;
+}
+
+static inline bool noza_edf_exhausted(thread_t *th)
+{
+    return noza_edf_thread(th) && th->edf.remaining <= 0;
+}
+
+static inline void noza_edf_charge(thread_t *th, int64_t used_us)
+{
+    if (!noza_edf_thread(th) || used_us <= 0) {
+        return;
+    }
+    noza_klock_acquire(&noza_sched_lock);
+    int64_t left = (int64_t)th->edf.remaining - used_us;
+    th->edf.remaining = (left < -(int64_t)th->edf.period) ? -(int32_t)th->edf.period : (int32_t)left;
+    noza_klock_release(&noza_sched_lock);
+}
+
+// the replenishment event fired (caller holds noza_timer_lock)
+static void noza_edf_replenish(thread_t *th, int64_t now)
+{
+    noza_edf_t *edf = &th->edf;
+    edf->period_start += edf->period;
+    if (edf->period_start + edf->period <= now) {
+        edf->period_start = now; // whole periods were missed, restart from now
+    }
+
+    noza_klock_acquire(&noza_sched_lock);
+    thread_list_t *from = noza_edf_queued_list(th);
+    if (from) {
+        noza_os_remove_thread(from, th); // the deadline is the queue key
+    }
+    edf->deadline = edf->period_start + edf->rel_deadline;
+    edf->remaining = (int32_t)edf->runtime;
+    if (from) {
+        noza_os_add_thread(noza_ready_target(th), th);
+    }
+    noza_klock_release(&noza_sched_lock);
+    noza_deadline_insert(&edf->event, edf->period_start + edf->period);
+}
+
+// drop the class bookkeeping of a thread that is not queued anywhere
+static void noza_edf_release(thread_t *th)
+{
+    if (!noza_edf_thread(th)) {
+        return;
+    }
+    noza_klock_acquire(&noza_timer_lock);
+    noza_deadline_cancel(&th->edf.event);
+    noza_klock_release(&noza_timer_lock);
+    noza_os.edf_util[th->edf.core] -= th->edf.util;
+    noza_os.edf_count--;
+    th->edf.period = 0;
+}
+
+// back to the fixed priority bands
+static void noza_edf_leave(thread_t *th)
+{
+    if (!noza_edf_thread(th)) {
+        return;
+    }
+    thread_list_t *from = noza_edf_queued_list(th);
+    if (from) {
+        noza_os_remove_thread(from, th);
+    }
+    noza_edf_release(th);
+    if (from) {
+        noza_os_add_thread(noza_ready_target(th), th);
+    }
+}
+
+// admission control: the core th is allowed on whose reserved share still fits util,
+// preferring the one it is on; -1 when none does
+static int noza_edf_pick_core(thread_t *th, uint32_t util)
+{
+    uint32_t limit = NOZA_EDF_UTIL_LIMIT * (NOZA_EDF_PPM / 100);
+    uint32_t allowed = th->affinity & NOZA_CORE_MASK_ALL;
+    uint32_t preferred = noza_edf_thread(th) ? th->edf.core : th->core;
+    for (uint32_t i = 0; i < NOZA_OS_NUM_CORES; i++) {
+        uint32_t c = (preferred + i) % NOZA_OS_NUM_CORES;
+        if ((allowed & (1u << c)) == 0) {
+            continue;
+        }
+        uint32_t used = noza_os.edf_util[c];
+        if (noza_edf_thread(th) && th->edf.core == c) {
+            used -= th->edf.util;
+        }
+        if (used + util <= limit) {
+            return (int)c;
+        }
+    }
+    return -1;
 }
 
 typedef struct {
@@ -1594,10 +3211,11 @@ static void noza_make_idle_context(uint32_t core)
 static void noza_make_app_context(thread_t *th, void (*entry)(void *param), void *param)
 {
     th->stack_ptr = arch_build_stack(
-        thread_get_vid(th), (uint32_t *)th->stack_area, NOZA_OS_STACK_SIZE, (void *)entry, param);
+        thread_get_vid(th), th->stack_area, th->stack_words, (void *)entry, param);
 }
 
-static uint32_t noza_os_thread_create(uint32_t *pth, void (*entry)(void *param), void *param, uint32_t priority, uint32_t reserved_vid)
+static uint32_t noza_os_thread_create(uint32_t *pth, void (*entry)(void *param), void *param, uint32_t priority,
+    uint32_t reserved_vid, uint32_t stack_words)
 {
     // sanity check
     if (priority >= NOZA_OS_PRIORITY_LIMIT) {
@@ -1608,13 +3226,23 @@ static uint32_t noza_os_thread_create(uint32_t *pth, void (*entry)(void *param),
     if (th == NULL) {
         return EAGAIN;
     }
-    noza_thread_set_identity(th, noza_os_get_running_thread());
+    th->stack_area = (uint32_t *)noza_arena_alloc(stack_words * sizeof(uint32_t));
+    if (th->stack_area == NULL) {
+        noza_os_add_thread(&noza_os.free, th);
+        return EAGAIN;
+    }
+    th->stack_words = stack_words;
+    thread_t *creator = noza_os_get_running_thread();
+    noza_thread_set_identity(th, creator);
     th->message.identity = th->identity;
     th->info.priority = priority;
+    th->info.base_priority = priority;
+    if (creator != NULL) {
+        th->affinity = creator->affinity; // inherit the creator's core affinity
+    }
     th->flags = 0x0;
     th->signal_pending = 0;
     th->signal_mask = 0;
-    noza_os_add_thread(&noza_os.ready[priority], th);
     noza_make_app_context(th, entry, param);
 
     if (reserved_vid != NOZA_VID_AUTO) {
@@ -1626,12 +3254,13 @@ static uint32_t noza_os_thread_create(uint32_t *pth, void (*entry)(void *param),
             assigned = true;
         }
 
-        if (assigned) {
-            noza_os_remove_vid(th);
-            noza_os_insert_vid_with_value(th, reserved_vid);
+        if (assigned && !noza_os_alias_vid(th, reserved_vid)) {
+            kernel_log("reserved vid %u dropped, alias table full\n", reserved_vid);
         }
     }
 
+    noza_os_add_thread(noza_ready_target(th), th); // publish once the context is built
+
     *pth = thread_get_vid(th);
     return 0; // success
 }
@@ -1648,16 +3277,18 @@ static void noza_switch_handler(uint32_t core)
 static void syscall_thread_sleep(thread_t *running)
 {
     int64_t duration = ((int64_t)running->trap.r1) << 32 | running->trap.r2;
+    // no domain lock is held here: give up the running slot before the thread becomes
+    // visible on a list another core can pick it from
+    noza_os_clear_running_thread();
     if (duration <= 0) {
         // Yielding still returns through the syscall path, so clear r0-r2
         // explicitly instead of leaking whatever trap values were already there.
         noza_os_set_return_value3(running, 0, 0, 0);
-        noza_os_add_thread(&noza_os.ready[running->info.priority], running);
+        noza_os_add_thread(noza_ready_target(running), running);
     } else { 
         running->expired_time = platform_get_absolute_time_us() + duration; // setup expired time
         noza_os_add_thread(&noza_os.sleep, running);
     }
-    noza_os_clear_running_thread();
 }
 
 static void do_nothing_signal_handler(thread_t *running, thread_t *target, uint32_t signum) {
@@ -1680,7 +3311,10 @@ static void stop_signal_handler(thread_t *running, thread_t *target, uint32_t si
 
     switch (target->info.state) {
     case THREAD_READY:
-        noza_os_change_state(target, &noza_os.ready[target->info.priority], &noza_os.stopped);
+        noza_os_change_state(target, noza_ready_list(target), &noza_os.stopped);
+        break;
+    case THREAD_THROTTLED:
+        noza_os_change_state(target, &noza_os.throttled, &noza_os.stopped);
         break;
     case THREAD_RUNNING:
         if (target != running) {
@@ -1705,7 +3339,7 @@ static void continue_signal_handler(thread_t *running, thread_t *target, uint32_
 {
     (void)signum;
     if (target->info.state == THREAD_STOPPED) {
-        noza_os_change_state(target, &noza_os.stopped, &noza_os.ready[target->info.priority]);
+        noza_os_change_state(target, &noza_os.stopped, noza_ready_target(target));
     }
     noza_os_set_return_value1(running, 0);
 }
@@ -1714,8 +3348,6 @@ static void alarm_signal_handler(thread_t *running, thread_t *target, uint32_t s
 {
     (void)signum;
     if (target->info.state == THREAD_SLEEP) {
-        // move to ready list
-        noza_os_change_state(target, &noza_os.sleep, &noza_os.ready[target->info.priority]);
         int64_t now_time = platform_get_absolute_time_us();
         if (now_time < target->expired_time) {
             int64_t remain = target->expired_time - now_time;
@@ -1725,26 +3357,25 @@ static void alarm_signal_handler(thread_t *running, thread_t *target, uint32_t s
         } else {
             noza_os_set_return_value3(target, EINTR, 0, 0);
         }
+        // move to ready list
+        noza_os_change_state(target, &noza_os.sleep, noza_ready_target(target));
         target->expired_time = 0;
     } else if (target->info.state == THREAD_WAITING_MSG) {
-        noza_os_change_state(target, &noza_os.wait, &noza_os.ready[target->info.priority]);
         noza_os_set_return_value1(target, EINTR);
+        noza_os_change_state(target, target->port_list, noza_ready_target(target));
     } else if (target->info.state == THREAD_WAITING_SYNC) {
         if (target->waiting_queue) {
             noza_wait_queue_remove(target->waiting_queue, target);
             target->waiting_queue = NULL;
         }
         noza_wait_queue_cancel_timeout(target);
-        noza_os_add_thread(&noza_os.ready[target->info.priority], target);
         noza_os_set_return_value1(target, EINTR);
-    } else if (target->info.state == THREAD_WAITING_READ) {
-        // target thread is in some thread's port.pending_list
-        // TODO: think faster way to remove the thread from pending list
-        kernel_log("fatal error: unimplement feature (1)\n");
-    } else if (target->info.state == THREAD_WAITING_REPLY) {
-        // target thread is in some thread's port.reply_list
-        // TODO: think faster way to remove the thread from reply list
-        kernel_log("fatal error: unimplement feature (2)\n");
+        noza_os_add_thread(noza_ready_target(target), target);
+    } else if ((target->info.state == THREAD_WAITING_READ ||
+                target->info.state == THREAD_WAITING_REPLY) && target->port_list != NULL) {
+        // target thread is in some thread's port.pending_list or port.reply_list
+        noza_os_set_return_value1(target, EINTR);
+        noza_os_change_state(target, target->port_list, noza_ready_target(target));
     } else {
         // A live thread may receive SIGALRM while runnable instead of blocked in
         // sleep/wait. Preserve the signal as pending and still report success to
@@ -1799,15 +3430,18 @@ static signal_handler_t signal_handler[32] = {
 
 inline static thread_t *get_thread_by_vid(uint32_t vid)
 {
-    int hash = hash32to8(vid);
-    vid_map_item_t *vp_map = noza_os.slot[hash];
-    while (vp_map) {
-        if (vp_map->vid == vid) {
-            return &noza_os.thread[vp_map->pid];
-        }
-        vp_map = vp_map->next;
+    // fast path: the index field names the TCB, a stale generation fails the compare
+    uint32_t index = vid & NOZA_VID_INDEX_MASK;
+    if (index < noza_os.tcb_count && noza_os.tcb[index]->vid == vid) {
+        return noza_os.tcb[index];
     }
 
+    for (int i = 0; i < NOZA_VID_ALIAS_LIMIT; i++) {
+        vid_alias_t *alias = &noza_os.vid_alias[i];
+        if (alias->thread != NULL && alias->vid == vid) {
+            return alias->thread;
+        }
+    }
     return NULL;
 }
 
@@ -1833,13 +3467,22 @@ static void syscall_thread_create(thread_t *running)
     if (running->trap.r2 != 0) {
         reserved_vid = *((uint32_t *)running->trap.r2);
     }
+    // the user stack comes from libc, the kernel entry stack only runs app_run's
+    // prologue and the exit path, so the caller sizes it
+    uint32_t stack_words = running->trap.r3 >> NSC_THREAD_CREATE_STACK_SHIFT;
+    if (stack_words == 0) {
+        stack_words = NOZA_OS_THREAD_STACK_SIZE;
+    } else if (stack_words < NOZA_OS_THREAD_STACK_MIN) {
+        stack_words = NOZA_OS_THREAD_STACK_MIN;
+    }
 
     uint32_t th, ret_value = noza_os_thread_create(
         &th,
         (void (*)(void *))running->trap.r1,
         (void *)running->trap.r2,
-        running->trap.r3,
-        reserved_vid);
+        running->trap.r3 & ((1u << NSC_THREAD_CREATE_STACK_SHIFT) - 1),
+        reserved_vid,
+        stack_words);
     noza_os_set_return_value2(running, ret_value, th);
 }
 
@@ -1868,6 +3511,7 @@ static void syscall_thread_join(thread_t *running)
         default:
             if (target->join_th == NULL) {
                 target->join_th = running;
+                running->join_target = target;
                 running->info.state = THREAD_PENDING_JOIN;
                 noza_os_clear_running_thread();
             } else {
@@ -1910,23 +3554,245 @@ static void syscall_thread_change_priority(thread_t *running)
         noza_os_set_return_value1(running, ESRCH); // error
         return;
     }
-    if (target == running) {
-        running->info.priority = running->trap.r2;
+    if (running_trap->r2 >= NOZA_OS_PRIORITY_LIMIT) {
+        noza_os_set_return_value1(running, EINVAL); // out of range, would corrupt the ready bitmap
+        return;
+    }
+    if (target->info.state == THREAD_FREE || target->info.state == THREAD_ZOMBIE) {
+        noza_os_set_return_value1(running, ESRCH); // error
+        return;
+    }
+    // a thread holding contended PI futexes keeps running at its waiters' priority
+    target->info.base_priority = running_trap->r2;
+    noza_pi_propagate(target);
+    noza_os_set_return_value1(running, 0);
+}
+
+// r1 = thread id (0 for the caller), r2 = noza_sched_deadline_t *, NULL to go back to
+// the fixed priority; EBUSY when the class has no room for the thread on an allowed core
+static void syscall_thread_set_deadline(thread_t *running)
+{
+    thread_t *target = running->trap.r1 == 0 ? running : get_thread_by_vid(running->trap.r1);
+    const noza_sched_deadline_t *attr = (const noza_sched_deadline_t *)running->trap.r2;
+    if (target == NULL || target->info.state == THREAD_FREE || target->info.state == THREAD_ZOMBIE) {
+        noza_os_set_return_value1(running, ESRCH);
+        return;
+    }
+    if (attr == NULL) {
         noza_os_set_return_value1(running, 0);
-    } else if (target->info.state != THREAD_READY) {
-        if (target->info.state == THREAD_FREE || target->info.state == THREAD_ZOMBIE) {
-            noza_os_set_return_value1(running, ESRCH); // error
-            return;
+        noza_edf_leave(target);
+        return;
+    }
+    uint32_t runtime = attr->runtime_us;
+    uint32_t rel_deadline = attr->deadline_us;
+    uint32_t period = attr->period_us;
+    if (runtime == 0 || runtime > rel_deadline || rel_deadline > period || period > INT32_MAX) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+    // admit on density: a deadline shorter than the period packs the runtime into a
+    // narrower window, and the sum of densities <= 1 is what keeps constrained EDF feasible
+    uint32_t util = (uint32_t)(((uint64_t)runtime * NOZA_EDF_PPM + rel_deadline - 1) / rel_deadline);
+    int core = noza_edf_pick_core(target, util);
+    if (core < 0 || (!noza_edf_thread(target) && noza_os.edf_count >= NOZA_EDF_MAX_THREADS)) {
+        noza_os_set_return_value1(running, EBUSY);
+        return;
+    }
+    noza_os_set_return_value1(running, 0);
+
+    thread_list_t *from = noza_edf_queued_list(target);
+    if (from) {
+        noza_os_remove_thread(from, target);
+    }
+    noza_edf_release(target);
+    noza_os.edf_util[core] += util;
+    noza_os.edf_count++;
+
+    int64_t now = platform_get_absolute_time_us();
+    noza_edf_t *edf = &target->edf;
+    edf->runtime = runtime;
+    edf->rel_deadline = rel_deadline;
+    edf->period = period;
+    edf->util = util;
+    edf->core = (uint8_t)core;
+    edf->period_start = now;
+    edf->deadline = now + rel_deadline;
+    edf->remaining = (int32_t)runtime;
+    noza_klock_acquire(&noza_timer_lock);
+    noza_deadline_insert(&edf->event, now + period);
+    noza_klock_release(&noza_timer_lock);
+
+    if (from) {
+        noza_os_add_thread(noza_ready_target(target), target);
+    } else if (target == running && (uint32_t)core != platform_get_running_core()) {
+        noza_os_add_thread(noza_ready_target(running), running); // move to the admitting core
+        noza_os_clear_running_thread();
+    }
+#if NOZA_OS_NUM_CORES > 1
+    else if (target->info.state == THREAD_RUNNING) {
+        // running on another core than the admitting one: that core's scheduler loop
+        // requeues it onto the admitting core's deadline list
+        for (uint32_t c = 0; c < NOZA_OS_NUM_CORES; c++) {
+            if (noza_os.running[c] == target && c != (uint32_t)core) {
+                platform_request_schedule((int)c);
+            }
+        }
+    }
+#endif
+}
+
+// r1 = noza_thread_stat_t *, r2 = max records, r3 = live threads to skip;
+// returns the number of records filled in, fewer than max once the table is done
+static void syscall_thread_stats(thread_t *running)
+{
+    noza_thread_stat_t *stats = (noza_thread_stat_t *)running->trap.r1;
+    uint32_t max = running->trap.r2;
+    uint32_t skip = running->trap.r3;
+    uint32_t count = 0;
+    if (stats == NULL && max > 0) {
+        noza_os_set_return_value2(running, EINVAL, 0);
+        return;
+    }
+    for (uint32_t i = 0; i < noza_os.tcb_count && count < max; i++) {
+        thread_t *th = noza_os.tcb[i];
+        if (th->info.state == THREAD_FREE) {
+            continue;
+        }
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        noza_thread_stat_t *st = &stats[count++];
+        st->vid = thread_get_vid(th);
+        st->state = (uint8_t)th->info.state;
+        st->priority = (uint8_t)th->info.priority;
+        st->last_core = th->acct.last_core;
+        st->reserved = 0;
+        st->run_us = th->acct.run_us;
+        st->voluntary_switches = th->acct.voluntary;
+        st->involuntary_switches = th->acct.involuntary;
+        st->syscalls = th->acct.syscalls;
+    }
+    noza_os_set_return_value2(running, 0, count);
+}
+
+// r1 = noza_trace_record_t *, r2 = max records; moves the oldest unread records of
+// every core out of the rings and returns how many were filled in
+static void syscall_trace_read(thread_t *running)
+{
+#if NOZA_OS_ENABLE_TRACE
+    noza_trace_record_t *out = (noza_trace_record_t *)running->trap.r1;
+    uint32_t max = running->trap.r2;
+    uint32_t count = 0;
+    if (out == NULL && max > 0) {
+        noza_os_set_return_value2(running, EINVAL, 0);
+        return;
+    }
+    for (uint32_t c = 0; c < NOZA_OS_NUM_CORES && count < max; c++) {
+        noza_trace_ring_t *ring = &noza_trace_ring[c];
+        uint32_t tail = ring->tail;
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        while (tail != head && count < max) {
+            out[count++] = ring->rec[tail & (NOZA_TRACE_RING_SIZE - 1)];
+            tail++;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        // drops happened after everything still queued, report them once the core is drained
+        uint32_t lost = ring->lost;
+        if (tail == head && lost != ring->lost_seen && count < max) {
+            noza_trace_record_t *rec = &out[count++];
+            rec->time_us = (uint32_t)platform_get_absolute_time_us();
+            rec->vid = 0;
+            rec->arg = lost - ring->lost_seen;
+            rec->extra = 0;
+            rec->event = NOZA_TRACE_LOST;
+            rec->core = (uint8_t)c;
+            ring->lost_seen = lost;
+        }
+    }
+    noza_os_set_return_value2(running, 0, count);
+#else
+    noza_os_set_return_value2(running, ENOSYS, 0);
+#endif
+}
+
+// r1 = non-zero to record events; returns the previous setting
+// r1 = noza_lock_stat_t *, r2 = max records; returns the number filled in. The
+// counters are statistics, read without taking the locks they describe
+static void syscall_lock_stats(thread_t *running)
+{
+    noza_lock_stat_t *stats = (noza_lock_stat_t *)running->trap.r1;
+    uint32_t max = running->trap.r2;
+    if (stats == NULL && max > 0) {
+        noza_os_set_return_value2(running, EINVAL, 0);
+        return;
+    }
+    uint32_t count = 0, index;
+    noza_klock_t *lock;
+    while (count < max && (lock = noza_klock_at(count, &index)) != NULL) {
+        noza_lock_stat_t *st = &stats[count++];
+        strncpy(st->name, lock->name, NOZA_LOCK_NAME_LEN - 1);
+        st->name[NOZA_LOCK_NAME_LEN - 1] = '\0';
+        st->index = index;
+        st->acquired = lock->acquired;
+        st->contended = lock->contended;
+    }
+    noza_os_set_return_value2(running, 0, count);
+}
+
+static void syscall_trace_enable(thread_t *running)
+{
+#if NOZA_OS_ENABLE_TRACE
+    uint32_t was = noza_trace_on;
+    noza_trace_on = running->trap.r1 != 0;
+    noza_os_set_return_value2(running, 0, was);
+#else
+    noza_os_set_return_value2(running, ENOSYS, 0);
+#endif
+}
+
+static void syscall_thread_set_affinity(thread_t *running)
+{
+    kernel_trap_info_t *running_trap = &running->trap;
+    thread_t *target = get_thread_by_vid(running_trap->r1);
+    uint32_t mask = running_trap->r2 & NOZA_CORE_MASK_ALL;
+    // sanity check
+    if (target == NULL || target->info.state == THREAD_FREE || target->info.state == THREAD_ZOMBIE) {
+        noza_os_set_return_value1(running, ESRCH); // error
+        return;
+    }
+    if (mask == 0) {
+        noza_os_set_return_value1(running, EINVAL); // no core left to run on
+        return;
+    }
+    if (noza_edf_thread(target) && (mask & (1u << target->edf.core)) == 0) {
+        noza_os_set_return_value1(running, EBUSY); // admitted on that core, leave the class first
+        return;
+    }
+
+    target->affinity = (uint8_t)mask;
+    noza_os_set_return_value1(running, 0);
+    if (target == running) {
+        if ((mask & (1u << platform_get_running_core())) == 0) {
+            // migrate now: requeue on an allowed core and give up this one
+            noza_os_add_thread(noza_ready_target(running), running);
+            noza_os_clear_running_thread();
+        }
+    } else if (target->info.state == THREAD_READY && (mask & (1u << target->core)) == 0) {
+        noza_os_remove_thread(noza_ready_list(target), target);
+        noza_os_add_thread(noza_ready_target(target), target);
+    }
+#if NOZA_OS_NUM_CORES > 1
+    else if (target->info.state == THREAD_RUNNING) {
+        // running on another core that the mask excludes: make that core reschedule now,
+        // its scheduler loop gives up a thread no longer allowed there
+        for (uint32_t c = 0; c < NOZA_OS_NUM_CORES; c++) {
+            if (noza_os.running[c] == target && (mask & (1u << c)) == 0) {
+                platform_request_schedule((int)c);
+            }
         }
-        target->info.priority = running_trap->r2;
-        noza_os_set_return_value1(running, 0);
-    } else {
-        // target is already in ready list
-        noza_os_remove_thread(&noza_os.ready[target->info.priority], target);
-        target->info.priority = running_trap->r2;
-        noza_os_add_thread(&noza_os.ready[target->info.priority], target);
-        noza_os_set_return_value1(running, 0);
     }
+#endif
 }
 
 static void syscall_thread_terminate(thread_t *running)
@@ -1951,7 +3817,7 @@ static void syscall_recv(thread_t *running)
 static void syscall_reply(thread_t *running)
 {
 #if NOZA_OS_ENABLE_IRQ
-    if (irq_try_handle_reply(running)) {
+    if (irq_try_handle_reply(running, running->trap.r1)) {
         return;
     }
 #endif
@@ -1959,9 +3825,45 @@ static void syscall_reply(thread_t *running)
     noza_os_reply(running, running_trap->r1, (void *)running_trap->r2, running_trap->r3);
 }
 
+// reply to one client and wait for the next message in a single trap; a client that
+// vanished before the reply does not stop the server from receiving
+static void syscall_reply_recv(thread_t *running)
+{
+    noza_msg_t *reply = (noza_msg_t *)running->trap.r1;
+    noza_msg_t *msg = (noza_msg_t *)running->trap.r2;
+    thread_t *client = NULL;
+
+    if (reply != NULL) {
+#if NOZA_OS_ENABLE_IRQ
+        if (!irq_try_handle_reply(running, reply->to_vid))
+#endif
+        client = noza_ipc_complete_reply(running, reply->to_vid, reply->ptr, reply->size);
+    }
+
+    running->pending_recv_msg = msg;
+#if NOZA_OS_ENABLE_IRQ
+    if (!irq_try_consume_event(running))
+#endif
+    noza_os_recv(running, msg);
+
+    // the server has either taken the next message or blocked in the wait list
+    if (client != NULL) {
+        noza_ipc_resume_client(running, client);
+    }
+}
+
 static void syscall_call(thread_t *running)
 {
     kernel_trap_info_t *running_trap = &running->trap;
+    if (NOZA_PORT_IS_ID(running_trap->r1)) {
+        noza_port_t *port = noza_port_get(running_trap->r1);
+        if (port == NULL) {
+            noza_os_set_return_value1(running, ESRCH);
+            return;
+        }
+        noza_port_send(running, port, (void *)running_trap->r2, running_trap->r3);
+        return;
+    }
     thread_t *target = get_thread_by_vid(running_trap->r1);
     // sanity check
     if (target == NULL) {
@@ -1974,31 +3876,232 @@ static void syscall_call(thread_t *running)
 static void syscall_nbcall(thread_t *running)
 {
     kernel_trap_info_t *running_trap = &running->trap;
+    if (NOZA_PORT_IS_ID(running_trap->r1)) {
+        noza_port_t *port = noza_port_get(running_trap->r1);
+        if (port == NULL) {
+            noza_os_set_return_value1(running, ESRCH);
+        } else if (port->receivers.count == 0) {
+            noza_os_set_return_value1(running, EAGAIN);
+        } else {
+            noza_port_send(running, port, (void *)running_trap->r2, running_trap->r3);
+        }
+        return;
+    }
     thread_t *target = get_thread_by_vid(running_trap->r1);
     // sanity check
     if (target == NULL) {
         noza_os_set_return_value1(running, ESRCH); // error
         return;
     }
-    noza_os_nonblock_send(running, target, (void *)running_trap->r1, running_trap->r2);
+    noza_os_nonblock_send(running, target, (void *)running_trap->r2, running_trap->r3);
+}
+
+// r1 = messages, r2 = status per message, r3 = count; messages left unanswered when a
+// failure ends the whole batch (the caller is interrupted, a server exits) keep ECANCELED
+static void syscall_call_batch(thread_t *running)
+{
+    noza_msg_t *msgs = (noza_msg_t *)running->trap.r1;
+    int32_t *status = (int32_t *)running->trap.r2;
+    uint32_t count = running->trap.r3;
+    if (msgs == NULL || status == NULL || count == 0 || count > NOZA_CALL_BATCH_MAX) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        status[i] = ECANCELED;
+    }
+    running->batch_msgs = msgs;
+    running->batch_status = status;
+    running->batch_count = (uint16_t)count;
+    running->batch_next = 0;
+
+    thread_t *receiver;
+    if (!noza_batch_submit(running, &receiver)) {
+        noza_batch_finish(running); // no message could be sent
+        return;
+    }
+    noza_os_clear_running_thread();
+    if (receiver != NULL && !noza_ipc_switch_to(receiver)) {
+        noza_os_add_thread(noza_ready_target(receiver), receiver);
+    }
+}
+
+// r1 = message (target, ptr, size and short words are read from it), r2 = tag; the
+// request is queued or handed to an idle receiver, the sender goes on running
+static void syscall_call_async(thread_t *running)
+{
+    noza_msg_t *msg = (noza_msg_t *)running->trap.r1;
+    if (msg == NULL) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+    noza_port_t *port = NULL;
+    thread_t *target = NULL;
+    if (NOZA_PORT_IS_ID(msg->to_vid)) {
+        port = noza_port_get(msg->to_vid);
+    } else {
+        target = get_thread_by_vid(msg->to_vid);
+        if (target != NULL && (target->info.state == THREAD_FREE || target->info.state == THREAD_ZOMBIE)) {
+            target = NULL;
+        }
+    }
+    if (port == NULL && target == NULL) {
+        noza_os_set_return_value1(running, ESRCH);
+        return;
+    }
+    noza_async_t *req = noza_async_alloc(running);
+    if (req == NULL) {
+        noza_os_set_return_value1(running, EAGAIN); // every record is in flight
+        return;
+    }
+    req->tag = running->trap.r2;
+    req->priority = running->info.priority;
+    noza_ipc_fill_message(&req->message, &running->identity, msg->to_vid, msg->ptr, msg->size, msg->word);
+    noza_os_set_return_value1(running, 0);
+
+    thread_t *receiver = NULL;
+    if (port != NULL) {
+        if (port->receivers.count > 0) {
+            receiver = port->receivers.head->value;
+            noza_os_remove_thread(&port->receivers, receiver);
+        } else {
+            noza_async_link(&port->async_list, req);
+            noza_poll_kick(NOZA_WAIT_PORT, NULL, noza_port_id(port));
+        }
+    } else if (target->info.port_state == PORT_READY) {
+        receiver = target;
+        receiver->info.port_state = PORT_WAIT_LISTEN;
+        noza_os_remove_thread(&noza_os.wait, receiver);
+    } else {
+        noza_async_link(&target->port.async_list, req);
+        noza_poll_kick(NOZA_WAIT_PORT, target, 0);
+    }
+    if (receiver != NULL) {
+        noza_async_deliver(receiver, req);
+        noza_os_add_thread(noza_ready_target(receiver), receiver);
+    }
+}
+
+// r1 = result, r2 = timeout in us (negative waits forever); ENOMSG when nothing is in flight
+static void syscall_async_wait(thread_t *running)
+{
+    noza_async_result_t *result = (noza_async_result_t *)running->trap.r1;
+    int32_t timeout_us = (int32_t)running->trap.r2;
+    if (result == NULL) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+    if (running->async_done.count > 0) {
+        noza_async_t *req = running->async_done.head->value;
+        noza_async_write_result(result, req);
+        noza_async_free(req);
+        noza_os_set_return_value1(running, 0);
+        return;
+    }
+    if (running->async_count == 0) {
+        noza_os_set_return_value1(running, ENOMSG);
+        return;
+    }
+    running->async_result = result;
+    int64_t wait_time = (timeout_us < 0) ? NOZA_WAIT_FOREVER : (int64_t)timeout_us;
+    int ret = noza_wait_queue_sleep(&noza_async_waiters, wait_time);
+    if (ret != 0) {
+        noza_os_set_return_value1(running, ret);
+    }
+}
+
+static void syscall_nbrecv(thread_t *running)
+{
+    noza_os_nonblock_recv(running, (noza_msg_t *)running->trap.r1);
+}
+
+// link or unlink every caller already queued on, or served by, the port of server
+static void noza_port_update_donors(thread_t *server, thread_list_t *list, bool donate)
+{
+    cdl_node_t *node = list->head;
+    for (uint32_t i = 0; i < list->count; i++) {
+        thread_t *client = node->value;
+        node = node->next;
+        if (donate && client->pi_owner == NULL) {
+            noza_pi_link(client, server);
+        } else if (!donate && client->pi_owner == server) {
+            noza_pi_unlink(client);
+        }
+    }
+}
+
+static void syscall_port_set_flags(thread_t *running)
+{
+    uint32_t flags = running->trap.r1;
+    if (flags & ~NOZA_PORT_FLAGS_ALL) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+    bool donate = (flags & NOZA_PORT_PRIORITY_DONATION) != 0;
+    bool donating = (running->port.flags & NOZA_PORT_PRIORITY_DONATION) != 0;
+    running->port.flags = flags;
+    if (donate != donating) {
+        noza_port_update_donors(running, &running->port.pending_list, donate);
+        noza_port_update_donors(running, &running->port.reply_list, donate);
+    }
+    noza_os_set_return_value1(running, 0);
+}
+
+static void syscall_port_create(thread_t *running)
+{
+    for (int i = 0; i < NOZA_MAX_PORTS; i++) {
+        noza_port_t *port = &noza_ports[i];
+        if (!port->in_use) {
+            port->in_use = 1;
+            port->owner_vid = thread_get_vid(running);
+            noza_os_set_return_value2(running, 0, noza_port_id(port));
+            return;
+        }
+    }
+    noza_os_set_return_value1(running, ENOMEM);
 }
 
-static void syscall_nbrecv(thread_t *running)
+static void syscall_port_destroy(thread_t *running)
 {
-    noza_os_nonblock_recv(running, (noza_msg_t *)running->trap.r1);
+    noza_port_t *port = noza_port_get(running->trap.r1);
+    if (port == NULL) {
+        noza_os_set_return_value1(running, ESRCH);
+        return;
+    }
+    if (port->owner_vid != thread_get_vid(running)) {
+        noza_os_set_return_value1(running, EPERM);
+        return;
+    }
+    noza_port_release(port, ESRCH);
+    noza_os_set_return_value1(running, 0);
 }
 
-static void syscall_futex_wait(thread_t *running)
+// NSC_REPLY_RECV for a worker of a port object: r1 = port id, r2 = reply (may be NULL),
+// r3 = receive buffer; the reply goes out even when the worker then blocks
+static void syscall_port_reply_recv(thread_t *running)
 {
-    uint32_t *addr = (uint32_t *)running->trap.r1;
-    uint32_t expected = running->trap.r2;
-    int32_t timeout_us = (int32_t)running->trap.r3;
+    noza_port_t *port = noza_port_get(running->trap.r1);
+    noza_msg_t *reply = (noza_msg_t *)running->trap.r2;
+    noza_msg_t *msg = (noza_msg_t *)running->trap.r3;
+    thread_t *client = NULL;
 
-    if (addr == NULL) {
-        noza_os_set_return_value1(running, EINVAL);
+    if (port == NULL) {
+        noza_os_set_return_value1(running, ESRCH); // nothing replied, noza_reply still can
         return;
     }
+    if (reply != NULL) {
+        client = noza_ipc_complete_reply(running, reply->to_vid, reply->ptr, reply->size);
+    }
+    noza_port_recv(running, port, msg);
+    if (client != NULL) {
+        noza_ipc_resume_client(running, client);
+    }
+}
 
+// caller holds noza_futex_bucket_lock(addr)
+static void noza_futex_wait(thread_t *running, uint32_t *addr, uint32_t expected, uint32_t bitset,
+    int32_t timeout_us)
+{
 #ifdef FUTEX_DEBUG
     FUTEX_LOG("wait entry addr=%p expected=%u timeout=%d actual=%u",
         addr, expected, timeout_us, *(volatile uint32_t *)addr);
@@ -2012,11 +4115,20 @@ static void syscall_futex_wait(thread_t *running)
         return;
     }
 
-    noza_wait_queue_t *queue = noza_futex_get_queue(addr, true);
-    if (queue == NULL) {
+    if (timeout_us == 0) {
+        noza_os_set_return_value1(running, ETIMEDOUT);
+        return;
+    }
+    // from here on the caller is queued, so a fresh entry never sits empty
+    noza_futex_entry_t *entry = noza_futex_get((uintptr_t)addr);
+    if (entry == NULL) {
         noza_os_set_return_value1(running, ENOMEM);
         return;
     }
+    noza_wait_queue_t *queue = &entry->queue;
+    running->futex_key = (uintptr_t)addr;
+    running->futex_bitset = bitset;
+    TRACE_EVENT(NOZA_TRACE_FUTEX_WAIT, thread_get_vid(running), addr, 0);
 
     int64_t wait_time = (timeout_us < 0) ? NOZA_WAIT_FOREVER : (int64_t)timeout_us;
 #ifdef FUTEX_DEBUG
@@ -2032,35 +4144,220 @@ static void syscall_futex_wait(thread_t *running)
     }
 }
 
+// caller holds noza_futex_bucket_lock(addr)
+static uint32_t noza_futex_wake(uint32_t *addr, uint32_t count, uint32_t bitset)
+{
+    if (count == 0)
+        return 0;
+
+#ifdef FUTEX_DEBUG
+    FUTEX_LOG("wake syscall addr=%p count=%u", addr, count);
+#endif
+
+    uint32_t woke = noza_futex_wake_key((uintptr_t)addr, count, bitset, 0);
+    noza_poll_kick(NOZA_WAIT_FUTEX, NULL, (uintptr_t)addr);
+#ifdef FUTEX_DEBUG
+    futex_wake_counter++;
+    futex_last_wake_count = woke;
+#endif
+#ifdef FUTEX_DEBUG
+    FUTEX_LOG("wake addr=%p count=%u woke=%u", addr, count, woke);
+#endif
+    return woke;
+}
+
+static void syscall_futex_wait(thread_t *running)
+{
+    uint32_t *addr = (uint32_t *)running->trap.r1;
+
+    if (addr == NULL) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+    noza_futex_wait(running, addr, running->trap.r2, NOZA_FUTEX_BITSET_ANY, (int32_t)running->trap.r3);
+}
+
 static void syscall_futex_wake(thread_t *running)
 {
     uint32_t *addr = (uint32_t *)running->trap.r1;
-    uint32_t count = running->trap.r2;
 
-    if (addr == NULL || count == 0) {
+    if (addr == NULL) {
         noza_os_set_return_value1(running, 0);
         return;
     }
+    noza_os_set_return_value1(running, noza_futex_wake(addr, running->trap.r2, NOZA_FUTEX_BITSET_ANY));
+}
 
-#ifdef FUTEX_DEBUG
-    FUTEX_LOG("wake syscall addr=%p count=%u", addr, count);
-#endif
+// caller holds noza_futex_bucket_lock(addr); the kernel is the only writer of a PI
+// word, so the uncontended path is a trap rather than a user-space compare-and-swap
+static void noza_futex_lock_pi(thread_t *running, uint32_t *addr, bool try_only, int32_t timeout_us)
+{
+    volatile uint32_t *word = (volatile uint32_t *)addr;
+    uint32_t self = NOZA_FUTEX_PI_WORD(thread_get_vid(running));
+    uint32_t current = *word & NOZA_FUTEX_PI_OWNER_MASK;
 
-    noza_wait_queue_t *queue = noza_futex_get_queue(addr, false);
-    if (queue == NULL) {
+    if (current == 0) {
+        *word = self | (*word & NOZA_FUTEX_PI_WAITERS);
         noza_os_set_return_value1(running, 0);
         return;
     }
+    if (current == self) {
+        noza_os_set_return_value1(running, EDEADLK);
+        return;
+    }
 
-    uint32_t woke = noza_wait_queue_wake(queue, count, 0);
-#ifdef FUTEX_DEBUG
-    futex_wake_counter++;
-    futex_last_wake_count = woke;
-#endif
-#ifdef FUTEX_DEBUG
-    FUTEX_LOG("wake addr=%p count=%u woke=%u remaining=%u", addr, count, woke, queue->count);
-#endif
-    noza_os_set_return_value1(running, woke);
+    thread_t *owner = get_thread_by_vid(NOZA_FUTEX_PI_OWNER(current));
+    if (owner == NULL || owner->info.state == THREAD_FREE || owner->info.state == THREAD_ZOMBIE) {
+        // the owner exited without unlocking, the caller inherits the lock
+        *word = self | (*word & NOZA_FUTEX_PI_WAITERS);
+        noza_os_set_return_value1(running, EOWNERDEAD);
+        return;
+    }
+    if (try_only || timeout_us == 0) {
+        noza_os_set_return_value1(running, try_only ? EBUSY : ETIMEDOUT);
+        return;
+    }
+
+    noza_futex_entry_t *entry = noza_futex_get((uintptr_t)addr);
+    if (entry == NULL) {
+        noza_os_set_return_value1(running, ENOMEM);
+        return;
+    }
+    *word |= NOZA_FUTEX_PI_WAITERS;
+    running->futex_key = (uintptr_t)addr;
+    running->futex_bitset = NOZA_FUTEX_BITSET_ANY;
+    noza_pi_link(running, owner);
+    int64_t wait_time = (timeout_us < 0) ? NOZA_WAIT_FOREVER : (int64_t)timeout_us;
+    noza_wait_queue_sleep(&entry->queue, wait_time);
+}
+
+// hand a PI futex owned by owner to its highest-priority waiter (FIFO among equals),
+// which returns from its lock call with result; caller holds noza_futex_bucket_lock(addr)
+static int noza_futex_unlock_pi(thread_t *owner, uint32_t *addr, int result)
+{
+    volatile uint32_t *word = (volatile uint32_t *)addr;
+    uintptr_t key = (uintptr_t)addr;
+    if ((*word & NOZA_FUTEX_PI_OWNER_MASK) != NOZA_FUTEX_PI_WORD(thread_get_vid(owner))) {
+        return EPERM;
+    }
+
+    noza_futex_entry_t *entry = noza_futex_lookup(key);
+    if (entry == NULL) {
+        *word = 0;
+        noza_poll_kick(NOZA_WAIT_FUTEX, NULL, key);
+        return 0;
+    }
+    uint32_t waiters = entry->queue.count;
+    thread_t *next = noza_futex_best_waiter(entry, NOZA_FUTEX_BITSET_ANY);
+
+    *word = NOZA_FUTEX_PI_WORD(thread_get_vid(next)) | (waiters > 1 ? NOZA_FUTEX_PI_WAITERS : 0);
+    noza_pi_transfer(owner, next, key);
+    noza_wait_queue_wake_thread(&entry->queue, next, result); // unlinks next, restoring the owner's priority
+    noza_poll_kick(NOZA_WAIT_FUTEX, NULL, key);
+    return 0;
+}
+
+// a terminating thread passes every contended PI futex it holds to the best waiter,
+// which sees EOWNERDEAD; caller holds every futex bucket lock
+static void noza_futex_release_pi_owned(thread_t *owner)
+{
+    while (owner->pi_waiters != NULL) {
+        thread_t *waiter = (thread_t *)owner->pi_waiters->value;
+        if (noza_futex_unlock_pi(owner, (uint32_t *)waiter->futex_key, EOWNERDEAD) != 0) {
+            noza_pi_unlink(waiter); // the word no longer names this owner
+        }
+    }
+}
+
+// extended futex operations; r1 points at a noza_futex_op_t, the handler takes the
+// bucket locks itself since requeue and wake-op span two addresses
+static void syscall_futex_op(thread_t *running)
+{
+    noza_futex_op_t *args = (noza_futex_op_t *)running->trap.r1;
+
+    if (args == NULL || args->addr == NULL) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+
+    uintptr_t key = (uintptr_t)args->addr;
+    uintptr_t key2 = (uintptr_t)args->addr2;
+    switch (args->op) {
+        case NOZA_FUTEX_WAIT_BITSET:
+            if (args->val3 == 0) {
+                noza_os_set_return_value1(running, EINVAL);
+                return;
+            }
+            noza_klock_acquire(noza_futex_bucket_lock(key));
+            noza_futex_wait(running, args->addr, args->val, args->val3, args->timeout_us);
+            noza_klock_release(noza_futex_bucket_lock(key));
+            break;
+
+        case NOZA_FUTEX_WAKE_BITSET:
+            if (args->val3 == 0) {
+                noza_os_set_return_value1(running, EINVAL);
+                return;
+            }
+            noza_klock_acquire(noza_futex_bucket_lock(key));
+            noza_os_set_return_value1(running, noza_futex_wake(args->addr, args->val, args->val3));
+            noza_klock_release(noza_futex_bucket_lock(key));
+            break;
+
+        case NOZA_FUTEX_REQUEUE:
+        case NOZA_FUTEX_CMP_REQUEUE:
+            if (args->addr2 == NULL) {
+                noza_os_set_return_value1(running, EINVAL);
+                return;
+            }
+            noza_futex_lock_pair(key, key2);
+            if (args->op == NOZA_FUTEX_CMP_REQUEUE && *(volatile uint32_t *)args->addr != args->val3) {
+                noza_os_set_return_value1(running, EAGAIN);
+            } else {
+                noza_os_set_return_value1(running, noza_futex_requeue_key(key, key2, args->val, args->val2));
+                noza_poll_kick(NOZA_WAIT_FUTEX, NULL, key); // pollers see a requeue like a wake
+            }
+            noza_futex_unlock_pair(key, key2);
+            break;
+
+        case NOZA_FUTEX_WAKE_OP: {
+            if (args->addr2 == NULL) {
+                noza_os_set_return_value1(running, EINVAL);
+                return;
+            }
+            bool wake2 = false;
+            noza_futex_lock_pair(key, key2);
+            int ret = noza_futex_apply_op(args->addr2, args->val3, &wake2);
+            if (ret != 0) {
+                noza_os_set_return_value1(running, ret);
+            } else {
+                uint32_t woke = noza_futex_wake(args->addr, args->val, NOZA_FUTEX_BITSET_ANY);
+                if (wake2) {
+                    woke += noza_futex_wake(args->addr2, args->val2, NOZA_FUTEX_BITSET_ANY);
+                }
+                noza_poll_kick(NOZA_WAIT_FUTEX, NULL, key2); // addr2 was written even when nobody woke
+                noza_os_set_return_value1(running, woke);
+            }
+            noza_futex_unlock_pair(key, key2);
+            break;
+        }
+
+        case NOZA_FUTEX_LOCK_PI:
+        case NOZA_FUTEX_TRYLOCK_PI:
+            noza_klock_acquire(noza_futex_bucket_lock(key));
+            noza_futex_lock_pi(running, args->addr, args->op == NOZA_FUTEX_TRYLOCK_PI, args->timeout_us);
+            noza_klock_release(noza_futex_bucket_lock(key));
+            break;
+
+        case NOZA_FUTEX_UNLOCK_PI:
+            noza_klock_acquire(noza_futex_bucket_lock(key));
+            noza_os_set_return_value1(running, noza_futex_unlock_pi(running, args->addr, 0));
+            noza_klock_release(noza_futex_bucket_lock(key));
+            break;
+
+        default:
+            noza_os_set_return_value1(running, ENOSYS);
+            break;
+    }
 }
 
 static void syscall_timer_create(thread_t *running)
@@ -2113,6 +4410,9 @@ static void syscall_timer_arm(thread_t *running)
 
     noza_timer_remove(timer);
     timer->flags = flags;
+    if (flags & NOZA_TIMER_FLAG_SLACK) {
+        timer->event.slack = running->event.slack;
+    }
     timer->period_us = (flags & NOZA_TIMER_FLAG_PERIODIC) ? (int64_t)duration_us : 0;
     timer->deadline = platform_get_absolute_time_us() + (int64_t)duration_us;
     timer->pending_fires = 0;
@@ -2140,6 +4440,30 @@ static void syscall_timer_cancel(thread_t *running)
     noza_os_set_return_value1(running, 0);
 }
 
+// r1 = timer id, or 0 for the calling thread's sleeps and timeouts; r2 = slack in us
+static void syscall_timer_slack(thread_t *running)
+{
+    uint32_t timer_id = running->trap.r1;
+    uint32_t slack_us = running->trap.r2;
+    if (timer_id == 0) {
+        running->event.slack = slack_us;
+        noza_os_set_return_value1(running, 0);
+        return;
+    }
+
+    noza_timer_t *timer = noza_timer_lookup(timer_id);
+    if (timer == NULL) {
+        noza_os_set_return_value1(running, ESRCH);
+        return;
+    }
+    if (timer->owner_vid != thread_get_vid(running)) {
+        noza_os_set_return_value1(running, EPERM);
+        return;
+    }
+    timer->event.slack = slack_us;
+    noza_os_set_return_value1(running, 0);
+}
+
 static void syscall_timer_wait(thread_t *running)
 {
     uint32_t timer_id = running->trap.r1;
@@ -2172,6 +4496,96 @@ static void syscall_timer_wait(thread_t *running)
     }
 }
 
+// is src ready for running; an error for a source that cannot be watched
+static int noza_poll_check(thread_t *running, noza_wait_source_t *src)
+{
+    src->ready = 0;
+    switch (src->type) {
+    case NOZA_WAIT_PORT:
+        if (src->id == 0) {
+            src->ready = (running->port.pending_list.count + running->port.async_list.count) > 0;
+        } else {
+            noza_port_t *port = noza_port_get(src->id);
+            if (port == NULL) {
+                return ESRCH;
+            }
+            src->ready = (port->pending_list.count + port->async_list.count) > 0;
+        }
+        return 0;
+    case NOZA_WAIT_TIMER: {
+        noza_timer_t *timer = noza_timer_lookup(src->id);
+        if (timer == NULL) {
+            return ESRCH;
+        }
+        if (timer->owner_vid != thread_get_vid(running)) {
+            return EPERM; // same rule as syscall_timer_wait
+        }
+        src->ready = timer->pending_fires > 0;
+        return 0;
+    }
+    case NOZA_WAIT_FUTEX:
+        if (src->addr == NULL) {
+            return EINVAL;
+        }
+        src->ready = *(volatile uint32_t *)src->addr != src->val;
+        return 0;
+#if NOZA_OS_ENABLE_IRQ
+    case NOZA_WAIT_IRQ:
+        if (src->id >= NOZA_PLATFORM_IRQ_COUNT) {
+            return EINVAL;
+        }
+        if (irq_bindings[src->id].owner_vid != thread_get_vid(running)) {
+            return EPERM; // only the bound server consumes the event
+        }
+        src->ready = irq_bindings[src->id].queued && !irq_bindings[src->id].inflight;
+        return 0;
+#endif
+    case NOZA_WAIT_ASYNC:
+        src->ready = running->async_done.count > 0;
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+// r1 = sources, r2 = count, r3 = timeout in us (negative waits forever); returns 0 with
+// the ready sources marked, or EAGAIN and the time left in r1 after a kick
+static void syscall_wait_any(thread_t *running)
+{
+    noza_wait_source_t *sources = (noza_wait_source_t *)running->trap.r1;
+    uint32_t count = running->trap.r2;
+    int32_t timeout_us = (int32_t)running->trap.r3;
+    if (sources == NULL || count == 0 || count > NOZA_WAIT_SOURCES_MAX) {
+        noza_os_set_return_value1(running, EINVAL);
+        return;
+    }
+
+    uint32_t kinds = 0;
+    uint32_t ready = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        int ret = noza_poll_check(running, &sources[i]);
+        if (ret != 0) {
+            noza_os_set_return_value1(running, ret);
+            return;
+        }
+        kinds |= 1u << sources[i].type;
+        ready += sources[i].ready;
+    }
+    if (ready > 0) {
+        noza_os_set_return_value1(running, 0);
+        return;
+    }
+
+    running->poll_kinds = (uint8_t)kinds;
+    running->poll_sources = sources; // stays put, the caller is blocked in this call
+    running->poll_count = (uint8_t)count;
+    int64_t wait_time = (timeout_us < 0) ? NOZA_WAIT_FOREVER : (int64_t)timeout_us;
+    int ret = noza_wait_queue_sleep(&noza_poll_waiters, wait_time);
+    if (ret != 0) {
+        noza_os_set_return_value1(running, ret);
+    }
+}
+
 static void syscall_clock_gettime(thread_t *running)
 {
     uint32_t clock_id = running->trap.r1;
@@ -2247,6 +4661,66 @@ static syscall_func_t syscall_func[] = {
     [NSC_CLOCK_GETTIME] = syscall_clock_gettime,
     [NSC_SIGNAL_SEND] = syscall_signal_send,
     [NSC_SIGNAL_TAKE] = syscall_signal_take,
+    [NSC_THREAD_SET_AFFINITY] = syscall_thread_set_affinity,
+    [NSC_FUTEX_OP] = syscall_futex_op,
+    [NSC_REPLY_RECV] = syscall_reply_recv,
+    [NSC_PORT_SET_FLAGS] = syscall_port_set_flags,
+    [NSC_PORT_CREATE] = syscall_port_create,
+    [NSC_PORT_DESTROY] = syscall_port_destroy,
+    [NSC_PORT_REPLY_RECV] = syscall_port_reply_recv,
+    [NSC_CALL_BATCH] = syscall_call_batch,
+    [NSC_CALL_ASYNC] = syscall_call_async,
+    [NSC_ASYNC_WAIT] = syscall_async_wait,
+    [NSC_WAIT_ANY] = syscall_wait_any,
+    [NSC_TIMER_SLACK] = syscall_timer_slack,
+    [NSC_THREAD_SET_DEADLINE] = syscall_thread_set_deadline,
+    [NSC_THREAD_STATS] = syscall_thread_stats,
+    [NSC_TRACE_READ] = syscall_trace_read,
+    [NSC_TRACE_ENABLE] = syscall_trace_enable,
+    [NSC_LOCK_STATS] = syscall_lock_stats,
+};
+
+// lock domains each syscall runs under (see "kernel lock domains")
+static const uint8_t syscall_lock_domain[NSC_NUM_SYSCALLS] = {
+    [NSC_THREAD_SLEEP] = 0,                     // sleep list / ready queue lock themselves
+    [NSC_THREAD_KILL] = KLOCK_ALL,
+    [NSC_THREAD_CREATE] = KLOCK_ALL,
+    [NSC_THREAD_CHANGE_PRIORITY] = KLOCK_ALL,
+    [NSC_THREAD_JOIN] = KLOCK_ALL,
+    [NSC_THREAD_DETACH] = KLOCK_ALL,
+    [NSC_THREAD_TERMINATE] = KLOCK_ALL,
+    [NSC_RECV] = KLOCK_IPC,
+    [NSC_REPLY] = KLOCK_IPC,
+    [NSC_CALL] = KLOCK_IPC,
+    [NSC_NB_RECV] = KLOCK_IPC,
+    [NSC_NB_CALL] = KLOCK_IPC,
+    [NSC_FUTEX_WAIT] = KLOCK_FUTEX,
+    [NSC_FUTEX_WAKE] = KLOCK_FUTEX,
+    [NSC_TIMER_CREATE] = KLOCK_TIMER,
+    [NSC_TIMER_DELETE] = KLOCK_TIMER,
+    [NSC_TIMER_ARM] = KLOCK_TIMER,
+    [NSC_TIMER_CANCEL] = KLOCK_TIMER,
+    [NSC_TIMER_WAIT] = KLOCK_TIMER,
+    [NSC_CLOCK_GETTIME] = KLOCK_TIMER,
+    [NSC_SIGNAL_SEND] = KLOCK_ALL,
+    [NSC_SIGNAL_TAKE] = KLOCK_SCHED,
+    [NSC_THREAD_SET_AFFINITY] = KLOCK_ALL,
+    [NSC_FUTEX_OP] = 0,                         // locks the bucket stripes of both addresses
+    [NSC_REPLY_RECV] = KLOCK_IPC,
+    [NSC_PORT_SET_FLAGS] = KLOCK_IPC,
+    [NSC_PORT_CREATE] = KLOCK_IPC,
+    [NSC_PORT_DESTROY] = KLOCK_IPC,
+    [NSC_PORT_REPLY_RECV] = KLOCK_IPC,
+    [NSC_CALL_BATCH] = KLOCK_IPC,
+    [NSC_CALL_ASYNC] = KLOCK_IPC,
+    [NSC_ASYNC_WAIT] = KLOCK_IPC,
+    [NSC_WAIT_ANY] = KLOCK_IPC | KLOCK_TIMER,   // port and irq state, then timers
+    [NSC_TIMER_SLACK] = KLOCK_TIMER,
+    [NSC_THREAD_SET_DEADLINE] = KLOCK_ALL,
+    [NSC_THREAD_STATS] = KLOCK_ALL,
+    [NSC_TRACE_READ] = KLOCK_SCHED,              // serializes readers, the rings need no lock
+    [NSC_TRACE_ENABLE] = 0,
+    [NSC_LOCK_STATS] = 0,                       // racy reads of statistics counters
 };
 
 inline static void serv_syscall(uint32_t core)
@@ -2254,13 +4728,19 @@ inline static void serv_syscall(uint32_t core)
     thread_t *source = noza_os.running[core];
     // sanity check
     if (source->callid < NSC_NUM_SYSCALLS) {
+        uint32_t domains = syscall_lock_domain[source->callid];
+        uintptr_t futex_key = source->trap.r1;
         source->trap.state = SYSCALL_SERVING;
+        noza_klock_enter(domains, futex_key);
         syscall_func[source->callid](source); 
+        noza_klock_leave(domains, futex_key);
     } else {
         if (source->callid == 255) {
             // TODO: handle hardfault
             arch_core_dump(source->stack_ptr, thread_get_vid(source));
+            noza_klock_enter(KLOCK_ALL, 0);
             syscall_thread_terminate(source);
+            noza_klock_leave(KLOCK_ALL, 0);
         } else {
             // system call not found !
             noza_os_set_return_value1(source, ENOSYS);
@@ -2270,83 +4750,102 @@ inline static void serv_syscall(uint32_t core)
 }
 
 //////////////////////////////////////////////////////////////
-inline static uint32_t noza_wakeup(int64_t now)
+// pop every expired entry from the deadline queue and dispatch it by kind
+static uint32_t noza_deadline_expire(int64_t now)
 {
-    if (noza_os.sleep.count == 0)
-        return 0;
-
-    uint32_t wakeup_count = 0;
-    cdl_node_t *cursor = noza_os.sleep.head;
-    while (cursor != NULL) {
-        thread_t *th = (thread_t *)cursor->value;
-        if (th->expired_time <= now) {
-            wakeup_count++;
-            noza_os_change_state(th, &noza_os.sleep, &noza_os.ready[th->info.priority]);
+    uint32_t expired_count = 0;
+    noza_deadline_t *entry;
+    noza_deadline_t *deferred[NOZA_DEADLINE_DEFER_MAX];
+    uint32_t deferred_count = 0;
+    noza_klock_acquire(&noza_timer_lock);
+    while ((entry = noza_deadline_peek()) != NULL && entry->when <= now) {
+        noza_klock_t *queue_lock = NULL;
+        if (entry->kind == NOZA_DEADLINE_SYNC) {
+            // a futex bucket ranks before the timer lock: only try it, and set the entry
+            // aside for the next pass when a waker on another core holds it
+            thread_t *th = DEADLINE_OWNER(entry, thread_t, event);
+            if (th->waiting_queue && th->waiting_queue->lock != &noza_timer_lock) {
+                queue_lock = th->waiting_queue->lock;
+                bool locked = noza_klock_try_acquire(queue_lock);
+                if (locked && th->waiting_queue && th->waiting_queue->lock != queue_lock) {
+                    // requeued onto another stripe before the lock was taken
+                    noza_klock_release(queue_lock);
+                    locked = false;
+                }
+                if (!locked) {
+                    if (deferred_count == NOZA_DEADLINE_DEFER_MAX) {
+                        break;
+                    }
+                    noza_deadline_cancel(entry);
+                    deferred[deferred_count++] = entry;
+                    continue;
+                }
+            }
+        }
+        noza_deadline_cancel(entry);
+        expired_count++;
+        switch (entry->kind) {
+        case NOZA_DEADLINE_TIMER: {
+            noza_timer_t *timer = DEADLINE_OWNER(entry, noza_timer_t, event);
+            TIMER_LOG("tick now=%" PRId64 " firing id=%u deadline=%" PRId64, now, timer->id, timer->deadline);
+            timer->armed = false;
+            TRACE_EVENT(NOZA_TRACE_TIMER_FIRE, timer->owner_vid, timer->id, 0);
+            noza_timer_fire(timer);
+            break;
+        }
+        case NOZA_DEADLINE_SLEEP: {
+            thread_t *th = DEADLINE_OWNER(entry, thread_t, event);
             noza_os_set_return_value3(th, 0, 0, 0); // return 0, high=0, low=0 successfully timeout
-            cursor = noza_os.sleep.head;
-        } else
+            noza_os_change_state(th, &noza_os.sleep, noza_ready_target(th));
             break;
-    }
-
-    return wakeup_count;
-}
-
-inline static uint32_t noza_wakeup_sync(int64_t now)
-{
-    if (noza_os.sync_sleep.count == 0)
-        return 0;
-
-    uint32_t wakeup_count = 0;
-    cdl_node_t *cursor = noza_os.sync_sleep.head;
-    while (cursor != NULL) {
-        thread_t *th = (thread_t *)cursor->value;
-        if (th->expired_time <= now) {
-            wakeup_count++;
-            noza_os_change_state(th, &noza_os.sync_sleep, &noza_os.ready[th->info.priority]);
+        }
+        case NOZA_DEADLINE_EDF: {
+            thread_t *th = DEADLINE_OWNER(entry, thread_t, edf.event);
+            noza_edf_replenish(th, now);
+            break;
+        }
+        case NOZA_DEADLINE_SYNC: {
+            thread_t *th = DEADLINE_OWNER(entry, thread_t, event);
             if (th->waiting_queue) {
                 noza_wait_queue_remove(th->waiting_queue, th);
                 th->waiting_queue = NULL;
             }
             th->flags &= ~FLAG_WAIT_TIMEOUT;
             noza_os_set_return_value1(th, ETIMEDOUT);
-            cursor = noza_os.sync_sleep.head;
-        } else {
+            noza_os_add_thread(noza_ready_target(th), th);
             break;
         }
+        default:
+            kernel_panic("unexpected: deadline entry kind %u\n", entry->kind);
+            break;
+        }
+        if (queue_lock) {
+            noza_klock_release(queue_lock);
+        }
     }
-    return wakeup_count;
+    // still under the timer lock, so a waker cannot cancel a deferred entry before it is back
+    for (uint32_t i = 0; i < deferred_count; i++) {
+        noza_deadline_insert(deferred[i], deferred[i]->when);
+    }
+    noza_klock_release(&noza_timer_lock);
+
+    return expired_count;
 }
 
-static inline int has_same_priority_peer(thread_t *running)
+static inline int has_same_priority_peer(uint32_t core, thread_t *running)
 {
-    if (running == NULL) {
-        return 0;
+    if (running == NULL || noza_edf_thread(running)) {
+        return 0; // deadline threads are ordered by deadline, they take no time slices
     }
-    return noza_os.ready[running->info.priority].count > 0;
+    return noza_os.ready[core][running->info.priority].count > 0;
 }
 
 static inline int64_t next_event_deadline(void)
 {
-    int64_t deadline = 0;
-    cdl_node_t *cursor = noza_os.sleep.head;
-    if (cursor) {
-        thread_t *th = (thread_t *)cursor->value;
-        deadline = th->expired_time;
-    }
-    cursor = noza_os.sync_sleep.head;
-    if (cursor) {
-        thread_t *th = (thread_t *)cursor->value;
-        if (deadline == 0 || th->expired_time < deadline) {
-            deadline = th->expired_time;
-        }
-    }
-    if (noza_timer_head) {
-        noza_timer_t *timer = (noza_timer_t *)noza_timer_head->value;
-        if (deadline == 0 || timer->deadline < deadline) {
-            deadline = timer->deadline;
-        }
-    }
-    return deadline;
+    noza_klock_acquire(&noza_timer_lock);
+    int64_t when = noza_deadline_next_wakeup();
+    noza_klock_release(&noza_timer_lock);
+    return when;
 }
 
 static inline void arm_next_scheduler_deadline(uint32_t core, int64_t now, thread_t *running)
@@ -2354,13 +4853,27 @@ static inline void arm_next_scheduler_deadline(uint32_t core, int64_t now, threa
     int64_t deadline = next_event_deadline();
 
     // Round-robin only matters when another peer at the same priority is ready.
-    if (has_same_priority_peer(running)) {
+    if (has_same_priority_peer(core, running)) {
         int64_t quantum_deadline = now + NOZA_OS_TIME_SLICE;
         if (deadline == 0 || quantum_deadline < deadline) {
             deadline = quantum_deadline;
         }
     }
 
+    // budget enforcement: take a deadline thread off the core when its runtime is gone
+    if (running != NULL && noza_edf_thread(running)) {
+        int64_t budget_end = now + (running->edf.remaining > 0 ? running->edf.remaining : 0);
+        if (deadline == 0 || budget_end < deadline) {
+            deadline = budget_end;
+        }
+    }
+
+    // a running thread reads the clock off its core's kdata slot, which must be
+    // rebased before the raw counter can wrap under it
+    if (running != NULL && (deadline == 0 || deadline - now > NOZA_KDATA_REFRESH_US)) {
+        deadline = now + NOZA_KDATA_REFRESH_US;
+    }
+
     noza_os.next_tick_time[core] = deadline;
     if (deadline == 0) {
         platform_systick_config(0);
@@ -2374,38 +4887,110 @@ static inline void arm_next_scheduler_deadline(uint32_t core, int64_t now, threa
     platform_systick_config((unsigned int)delta);
 }
 
-// switch to user stack
-inline static void GO_RUN(int core, thread_t *running)
+// publish the running vid and a fresh clock base in the core's kdata slot
+static inline void noza_kdata_update(uint32_t core, uint32_t vid)
+{
+    noza_kdata_core_t *slot = &noza_kdata.core[core];
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_SEQ_CST);
+    slot->vid = vid;
+    slot->base_us = platform_get_absolute_time_us();
+    slot->base_count = platform_get_clock_count(); // read after base_us, so readers never run ahead
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_SEQ_CST);
+}
+
+// switch to user stack, returns the time the thread trapped back into the kernel
+inline static int64_t GO_RUN(int core, thread_t *running)
 {
-    NOZAOS_PID[core] = thread_get_vid(running); // setup the shared variable
+    noza_kdata_update(core, thread_get_vid(running)); // setup the shared variable
 #if NOZA_OS_ENABLE_IRQ
     irq_process_pending();
 #endif
+    TRACE_SWITCH(core, thread_get_vid(running));
+    running->acct.last_core = (uint8_t)core;
+    int64_t start = platform_get_absolute_time_us();
     noza_os_unlock(core);
     running->stack_ptr = arch_resume_thread(running->stack_ptr);
     noza_os_lock(core); 
+    int64_t end = platform_get_absolute_time_us();
+    running->acct.run_us += (uint64_t)(end - start);
+    return end;
 }
 
 // switch to idle stack
 inline static void GO_IDLE(int core)
 {
+    TRACE_SWITCH(core, 0);
     noza_os_unlock(core);
     idle_task[core].idle_stack_ptr = arch_resume_thread(idle_task[core].idle_stack_ptr);
     noza_os_lock(core);
 }
 
-// pick a thread from ready queue base on priority
-inline static thread_t *pick_ready_thread()
+#if NOZA_OS_NUM_CORES > 1
+// the local queue is empty: pull the best thread allowed on this core from a peer queue
+static thread_t *steal_ready_thread(uint32_t core)
 {
-    thread_t *running = NULL;
-    // travel the ready queue list and find the highest priority thread
-    for (int i=0; i<NOZA_OS_PRIORITY_LIMIT; i++) {
-        if (noza_os.ready[i].count > 0) {
-            running = noza_os.ready[i].head->value;
-            noza_os_remove_thread(&noza_os.ready[i], running);
-            break;
+    thread_t *best = NULL;
+    for (uint32_t c = 0; c < NOZA_OS_NUM_CORES; c++) {
+        if (c == core) {
+            continue;
+        }
+        uint32_t bitmap = noza_os.ready_bitmap[c];
+        while (bitmap != 0) {
+            uint32_t level = __builtin_clz(bitmap);
+            if (best != NULL && best->info.priority <= level) {
+                break;
+            }
+            thread_list_t *list = &noza_os.ready[c][level];
+            thread_t *th = list->head->value;
+            for (uint32_t i = 0; i < list->count; i++) {
+                if (th->affinity & (1u << core)) {
+                    best = th;
+                    break;
+                }
+                th = th->state_node.next->value;
+            }
+            if (best != NULL && best->info.priority == level) {
+                break;
+            }
+            bitmap &= ~READY_BIT(level);
         }
     }
+
+    if (best != NULL) {
+        noza_os_remove_thread(noza_ready_list(best), best);
+        best->core = (uint8_t)core;
+    }
+    return best;
+}
+#endif
+
+// pick a thread from the core's ready queue base on priority and make it the running one
+inline static thread_t *pick_ready_thread(uint32_t core)
+{
+    thread_t *running = NULL;
+    noza_klock_acquire(&noza_sched_lock);
+    uint32_t bitmap = noza_os.ready_bitmap[core];
+    thread_list_t *edf = &noza_os.edf_ready[core];
+    if (edf->count > 0) {
+        // the deadline class runs ahead of every priority band
+        running = edf->head->value;
+        noza_os_remove_thread(edf, running);
+    } else if (bitmap != 0) {
+        // the leading set bit is the highest non-empty priority level
+        thread_list_t *list = &noza_os.ready[core][__builtin_clz(bitmap)];
+        running = list->head->value;
+        noza_os_remove_thread(list, running);
+    }
+#if NOZA_OS_NUM_CORES > 1
+    else {
+        running = steal_ready_thread(core);
+    }
+#endif
+    if (running) {
+        running->info.state = THREAD_RUNNING;
+        noza_os.running[core] = running;
+    }
+    noza_klock_release(&noza_sched_lock);
     return running;
 }
 
@@ -2413,8 +4998,10 @@ inline static void check_syscall_output(thread_t *running)
 {
     if (running->trap.state == SYSCALL_OUTPUT) {
         arch_trap(running->stack_ptr, &running->trap); // copy register to trap structure
+        TRACE_EVENT(NOZA_TRACE_SYSCALL_EXIT, thread_get_vid(running), running->trap.r0, running->callid);
         running->trap.state = SYSCALL_DONE; // clear the state
         running->callid = -1; // clear the callid
+        running->batch_msgs = NULL; // a batched call ends here, whichever path finished it
     }
 }
 
@@ -2422,18 +5009,23 @@ inline static void check_syscall_serve(int core, thread_t *running)
 {
     if (running->trap.state == SYSCALL_PENDING) {
         running->callid = running->trap.r0; // save the callid
+        running->acct.syscalls++;
+        TRACE_EVENT(NOZA_TRACE_SYSCALL_ENTER, thread_get_vid(running), running->trap.r1, running->callid);
         serv_syscall(core);
     }
 }
 
-inline static int is_with_higher_priority_thread(thread_t *running)
+inline static int is_with_higher_priority_thread(uint32_t core, thread_t *running)
 {
-    for (int i=0; i<running->info.priority; i++) {
-        if (noza_os.ready[i].count > 0) {
-            return 1;
-        }
+    thread_list_t *edf = &noza_os.edf_ready[core];
+    if (edf->count > 0) {
+        return !noza_edf_thread(running) || noza_edf_before((thread_t *)edf->head->value, running);
     }
-    return 0;
+    if (noza_edf_thread(running)) {
+        return 0;
+    }
+    // mask keeps the bits of levels 0 .. priority-1 (empty mask for priority 0)
+    return (noza_os.ready_bitmap[core] & ~(0xFFFFFFFFu >> running->info.priority)) != 0;
 }
 
 static void noza_os_scheduler()
@@ -2452,33 +5044,43 @@ static void noza_os_scheduler()
     noza_os.next_tick_time[core] = 0;
     for (;;) {
         int64_t now = platform_get_absolute_time_us();
-        noza_timer_tick(now);
-        noza_wakeup(now);
-        noza_wakeup_sync(now);
+        noza_deadline_expire(now);
 #if NOZA_OS_ENABLE_IRQ
         irq_process_pending();
 #endif
-        thread_t *running = pick_ready_thread();
+        thread_t *running = pick_ready_thread(core);
         if (running) {
             // a ready thread is picked
-            running->info.state = THREAD_RUNNING;
-            noza_os.running[core] = running;
             for (;;) {
                 check_syscall_output(running); // check if the call pending on output
                 arm_next_scheduler_deadline(core, now, running);
-                GO_RUN(core, running);
-                now = platform_get_absolute_time_us();  // update time
-                noza_timer_tick(now);
-                noza_wakeup(now);
-                noza_wakeup_sync(now);
+                int64_t run_start = now;
+                now = GO_RUN(core, running);            // update time
+                noza_edf_charge(running, now - run_start);
+                noza_deadline_expire(now);
                 check_syscall_serve(core, running);     // check if any syscall is pending, if pending, then serve it
-                if (noza_os.running[core] == NULL) {
-                    break;
+                if (noza_os.running[core] != running) {
+                    // the thread blocked, or an IPC syscall switched straight to its peer
+                    running->acct.voluntary++;
+                    running = noza_os.running[core];
+                    if (running == NULL) {
+                        break;
+                    }
+                    continue;
+                }
+                if (noza_edf_exhausted(running)) {
+                    break; // out of runtime: requeued as throttled below
+                }
+                if ((running->affinity & (1u << core)) == 0) {
+                    break; // the affinity mask changed while it ran, requeue on an allowed core
+                }
+                if (noza_edf_thread(running) && running->edf.core != core) {
+                    break; // admitted to the deadline class on another core, migrate there
                 }
-                if (is_with_higher_priority_thread(running)) {
+                if (is_with_higher_priority_thread(core, running)) {
                     break;
                 }
-                if (has_same_priority_peer(running) &&
+                if (has_same_priority_peer(core, running) &&
                     noza_os.next_tick_time[core] != 0 &&
                     now >= noza_os.next_tick_time[core]) {
                     break;
@@ -2486,8 +5088,11 @@ static void noza_os_scheduler()
             }
             running = noza_os.running[core];
             if (running != NULL) {
-                noza_os_add_thread(&noza_os.ready[running->info.priority], running);
+                running->acct.involuntary++; // preempted while still runnable
+                noza_klock_acquire(&noza_sched_lock);
+                noza_os_add_thread(noza_ready_target(running), running);
                 noza_os.running[core] = NULL;
+                noza_klock_release(&noza_sched_lock);
             }
         } else {
             // there is no candidate thread to run, arm the next event deadline and go idle
@@ -11,6 +11,8 @@ uint32_t    platform_get_running_core();
 void        platform_multicore_init(void (*noza_os_scheduler)(void));
 void        platform_request_schedule(int target_core);
 int64_t     platform_get_absolute_time_us();
+uint32_t    platform_get_clock_count(void);    // free-running up-counter, readable from thread mode
+uint32_t    platform_get_clock_hz(void);
 uint32_t    platform_get_random();
 void        platform_systick_config(unsigned int n);
 void        platform_tick_cores();
@@ -19,6 +21,8 @@ void        platform_panic(const char *msg, ...);
 void        platform_os_lock_init();
 void        platform_os_lock(uint32_t core);
 void        platform_os_unlock(uint32_t core);
+bool        platform_spin_try_claim(volatile uint32_t *word);
+void        platform_spin_release(volatile uint32_t *word);
 uint32_t    platform_interrupt_disable(void);
 void        platform_interrupt_restore(uint32_t flags);
 void        platform_trigger_pendsv(void);
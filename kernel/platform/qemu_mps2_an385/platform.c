@@ -114,6 +114,17 @@ int64_t platform_get_absolute_time_us(void)
     return (int64_t)(ticks / (uint64_t)(QEMU_MPS2_SYSCLK_HZ / 1000000u));
 }
 
+uint32_t platform_get_clock_count(void)
+{
+    // timer 1 counts down from 0xFFFFFFFF, so its complement counts up
+    return ~TIMER1_VALUE;
+}
+
+uint32_t platform_get_clock_hz(void)
+{
+    return QEMU_MPS2_SYSCLK_HZ;
+}
+
 int platform_uart_getchar_timeout_us(uint32_t timeout_us)
 {
     if (timeout_us == 0) {
@@ -227,6 +238,18 @@ void platform_os_unlock(uint32_t core)
     platform_interrupt_restore(interrupt_state[core]);
 }
 
+// single core: kernel locks never contend, the word only keeps the kernel bookkeeping uniform
+bool platform_spin_try_claim(volatile uint32_t *word)
+{
+    *word = 1;
+    return true;
+}
+
+void platform_spin_release(volatile uint32_t *word)
+{
+    *word = 0;
+}
+
 uint32_t platform_get_random(void)
 {
     random_state ^= random_state << 13;
@@ -11,6 +11,7 @@
 #include "hardware/regs/rosc.h"
 #include "hardware/structs/scb.h"
 #include "hardware/structs/systick.h"
+#include "hardware/structs/timer.h"
 #include "hardware/sync.h"
 #include "hardware/uart.h"
 #if NOZA_OS_NUM_CORES > 1
@@ -174,6 +175,17 @@ int64_t platform_get_absolute_time_us(void)
     return to_us_since_boot(get_absolute_time());
 }
 
+uint32_t platform_get_clock_count(void)
+{
+    // raw low word of the 1 MHz timer, reading it does not latch the high word
+    return timer_hw->timerawl;
+}
+
+uint32_t platform_get_clock_hz(void)
+{
+    return 1000000u;
+}
+
 void platform_systick_config(unsigned int n)
 {
     systick_hw->csr = 0;
@@ -238,29 +250,54 @@ void platform_panic(const char *msg, ...)
 }
 
 static uint32_t interrupt_state[NOZA_OS_NUM_CORES];
-static volatile noza_spin_lock_t *spinlock;
 
 void platform_os_lock_init(void)
 {
     for (int i = 0; i < NOZA_OS_NUM_CORES; i++) {
         interrupt_state[i] = 0;
     }
-    int spinlock_num_count = spin_lock_claim_unused(true);
-    spinlock = spin_lock_init(spinlock_num_count);
+    spin_lock_init(PICO_SPINLOCK_ID_OS1);
 }
 
+// enter/leave the kernel on this core; shared state is guarded by the kernel's own spin locks
 void platform_os_lock(uint32_t core)
 {
     interrupt_state[core] = platform_interrupt_disable();
-    spin_lock_unsafe_blocking(spinlock);
 }
 
 void platform_os_unlock(uint32_t core)
 {
-    spin_unlock_unsafe(spinlock);
     platform_interrupt_restore(interrupt_state[core]);
 }
 
+// kernel lock words are claimed under the SIO spinlock the SDK reserves for an OS, so the
+// number of kernel locks is not limited by the hardware spinlock count
+static inline spin_lock_t *kernel_lock_guard(void)
+{
+    return spin_lock_instance(PICO_SPINLOCK_ID_OS1);
+}
+
+bool platform_spin_try_claim(volatile uint32_t *word)
+{
+    if (*word != 0) {
+        return false;
+    }
+    spin_lock_t *guard = kernel_lock_guard();
+    spin_lock_unsafe_blocking(guard);
+    bool claimed = (*word == 0);
+    if (claimed) {
+        *word = 1;
+    }
+    spin_unlock_unsafe(guard);
+    return claimed;
+}
+
+void platform_spin_release(volatile uint32_t *word)
+{
+    __mem_fence_release();
+    *word = 0;
+}
+
 uint32_t platform_get_random(void)
 {
     uint32_t random = 0;
@@ -4,6 +4,7 @@
 #define NSC_THREAD_SLEEP                0
 #define NSC_THREAD_KILL                 1
 #define NSC_THREAD_CREATE               2
+#define NSC_THREAD_CREATE_STACK_SHIFT   16  // r3 = priority | (entry stack words << 16), 0 words = default
 #define NSC_THREAD_CHANGE_PRIORITY      3
 #define NSC_THREAD_JOIN                 4
 #define NSC_THREAD_DETACH               5
@@ -25,11 +26,29 @@
 #define NSC_CLOCK_GETTIME               19
 #define NSC_SIGNAL_SEND                 20
 #define NSC_SIGNAL_TAKE                 21
+#define NSC_THREAD_SET_AFFINITY         22
+#define NSC_FUTEX_OP                    23
+#define NSC_REPLY_RECV                  24
+#define NSC_PORT_SET_FLAGS              25
+#define NSC_PORT_CREATE                 26
+#define NSC_PORT_DESTROY                27
+#define NSC_PORT_REPLY_RECV             28
+#define NSC_CALL_BATCH                  29
+#define NSC_CALL_ASYNC                  30
+#define NSC_ASYNC_WAIT                  31
+#define NSC_WAIT_ANY                    32
+#define NSC_TIMER_SLACK                 33
+#define NSC_THREAD_SET_DEADLINE         34
+#define NSC_THREAD_STATS                35
+#define NSC_TRACE_READ                  36
+#define NSC_TRACE_ENABLE                37
+#define NSC_LOCK_STATS                  38
 
-#define NSC_NUM_SYSCALLS                22
+#define NSC_NUM_SYSCALLS                39
 
 // timer flags
 #define NOZA_TIMER_FLAG_PERIODIC        0x01
+#define NOZA_TIMER_FLAG_SLACK           0x02    // take the arming thread's slack
 
 // clock ids
 #define NOZA_CLOCK_REALTIME             0
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Convert a NozaOS kernel trace dump into Chrome trace JSON (chrome://tracing, Perfetto).
+
+The input is either the raw /dev/trace stream (an array of 16-byte
+noza_trace_record_t) or a console log holding the "trace: ..." lines printed by
+the shell `trace` command.
+"""
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+from typing import Dict, Iterable, List, Tuple
+
+
+RECORD = struct.Struct("<IIIHBB")   # time_us, vid, arg, extra, event, core
+LINE_RE = re.compile(r"trace: ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})")
+NSC_RE = re.compile(r"#define\s+NSC_(\w+)\s+(\d+)")
+
+SWITCH = 1
+SYSCALL_ENTER = 2
+SYSCALL_EXIT = 3
+IPC_SEND = 4
+IPC_RECV = 5
+IPC_REPLY = 6
+FUTEX_WAIT = 7
+FUTEX_WAKE = 8
+TIMER_FIRE = 9
+IRQ = 10
+LOST = 11
+
+CORE_PID = 0
+THREAD_PID = 1
+
+Record = Tuple[int, int, int, int, int, int]
+
+
+def load_syscall_names(path: str) -> Dict[int, str]:
+    names: Dict[int, str] = {}
+    try:
+        with open(path, "r", encoding="utf-8") as fp:
+            for match in NSC_RE.finditer(fp.read()):
+                if match.group(1) != "NUM_SYSCALLS":
+                    names[int(match.group(2))] = match.group(1).lower()
+    except OSError:
+        pass
+    return names
+
+
+def read_records(path: str) -> List[Record]:
+    with open(path, "rb") as fp:
+        data = fp.read()
+    text = data.decode("latin1")
+    lines = LINE_RE.findall(text)
+    if lines:
+        data = b"".join(struct.pack("<IIII", *(int(word, 16) for word in line)) for line in lines)
+    usable = len(data) - len(data) % RECORD.size
+    return [RECORD.unpack_from(data, off) for off in range(0, usable, RECORD.size)]
+
+
+def unwrap_times(records: Iterable[Record]) -> List[Tuple[int, Record]]:
+    # timestamps are the low 32 bits of the clock; each core's records come out in order
+    last: Dict[int, int] = {}
+    high: Dict[int, int] = {}
+    out = []
+    for rec in records:
+        core = rec[5]
+        t = rec[0]
+        if core in last and t < last[core] and last[core] - t > 0x80000000:
+            high[core] = high.get(core, 0) + (1 << 32)
+        last[core] = t
+        out.append((t + high.get(core, 0), rec))
+    out.sort(key=lambda item: item[0])
+    return out
+
+
+def thread_name(vid: int) -> str:
+    return f"vid {vid:#x}"
+
+
+def convert(records: List[Record], syscalls: Dict[int, str]) -> dict:
+    events = []
+    threads = set()
+    cores = set()
+    running: Dict[int, Tuple[int, int]] = {}    # core -> (vid, start)
+    in_syscall: Dict[int, int] = {}             # vid -> open syscall depth
+
+    def instant(ts: int, pid: int, tid: int, name: str, args: dict) -> None:
+        events.append({"name": name, "ph": "i", "s": "t", "ts": ts, "pid": pid, "tid": tid, "args": args})
+
+    timeline = unwrap_times(records)
+    for ts, (_, vid, arg, extra, event, core) in timeline:
+        cores.add(core)
+        if vid:
+            threads.add(vid)
+        if event == SWITCH:
+            prev = running.get(core)
+            if prev is not None and prev[0] != 0:
+                events.append({"name": thread_name(prev[0]), "ph": "X", "ts": prev[1], "dur": ts - prev[1],
+                               "pid": CORE_PID, "tid": core})
+            running[core] = (vid, ts)
+        elif event == SYSCALL_ENTER:
+            in_syscall[vid] = in_syscall.get(vid, 0) + 1
+            events.append({"name": syscalls.get(extra, f"syscall {extra}"), "ph": "B", "ts": ts,
+                           "pid": THREAD_PID, "tid": vid, "args": {"r1": hex(arg), "core": core}})
+        elif event == SYSCALL_EXIT:
+            if in_syscall.get(vid, 0) > 0:    # the call may have started before the dump
+                in_syscall[vid] -= 1
+                events.append({"ph": "E", "ts": ts, "pid": THREAD_PID, "tid": vid,
+                               "args": {"result": arg, "core": core}})
+        elif event == IPC_SEND:
+            instant(ts, THREAD_PID, vid, "ipc send", {"to": hex(arg), "size": extra})
+        elif event == IPC_RECV:
+            instant(ts, THREAD_PID, vid, "ipc recv", {"from": hex(arg), "size": extra})
+        elif event == IPC_REPLY:
+            instant(ts, THREAD_PID, vid, "ipc reply", {"to": hex(arg), "size": extra})
+        elif event == FUTEX_WAIT:
+            instant(ts, THREAD_PID, vid, "futex wait", {"addr": hex(arg)})
+        elif event == FUTEX_WAKE:
+            instant(ts, THREAD_PID, vid, "futex wake", {"addr": hex(arg)})
+        elif event == TIMER_FIRE:
+            instant(ts, CORE_PID, core, "timer fire", {"timer": arg, "owner": hex(vid)})
+        elif event == IRQ:
+            instant(ts, CORE_PID, core, "irq", {"irq": arg})
+        elif event == LOST:
+            events.append({"name": "records lost", "ph": "i", "s": "g", "ts": ts, "pid": CORE_PID, "tid": core,
+                           "args": {"count": arg, "core": core}})
+
+    if timeline:
+        end = timeline[-1][0]
+        for core, (vid, start) in running.items():
+            if vid != 0:
+                events.append({"name": thread_name(vid), "ph": "X", "ts": start, "dur": end - start,
+                               "pid": CORE_PID, "tid": core})
+
+    meta = [
+        {"name": "process_name", "ph": "M", "pid": CORE_PID, "args": {"name": "cores"}},
+        {"name": "process_name", "ph": "M", "pid": THREAD_PID, "args": {"name": "threads"}},
+    ]
+    meta += [{"name": "thread_name", "ph": "M", "pid": CORE_PID, "tid": core, "args": {"name": f"core {core}"}}
+             for core in sorted(cores)]
+    meta += [{"name": "thread_name", "ph": "M", "pid": THREAD_PID, "tid": vid, "args": {"name": thread_name(vid)}}
+             for vid in sorted(threads)]
+    return {"traceEvents": meta + events, "displayTimeUnit": "ms"}
+
+
+def main() -> int:
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description="Convert a NozaOS trace dump to Chrome trace JSON")
+    parser.add_argument("dump", help="raw /dev/trace dump or a console log with 'trace:' lines")
+    parser.add_argument("-o", "--output", help="output JSON file (default: stdout)")
+    parser.add_argument("--syscalls", default=os.path.join(root, "kernel", "syscall.h"),
+                        help="syscall.h used to name syscall numbers")
+    args = parser.parse_args()
+
+    records = read_records(args.dump)
+    if not records:
+        print(f"no trace records found in {args.dump}", file=sys.stderr)
+        return 1
+    trace = convert(records, load_syscall_names(args.syscalls))
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as fp:
+            json.dump(trace, fp)
+    else:
+        json.dump(trace, sys.stdout)
+        sys.stdout.write("\n")
+    print(f"{len(records)} records", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -613,16 +613,19 @@ static int app_launcher_service(void *param, uint32_t pid)
     }
 
     noza_msg_t msg;
+    noza_msg_t *reply = NULL; // answered by the next noza_reply_recv
     for (;;) {
-        if (noza_recv(&msg) != 0) {
+        int ret = noza_reply_recv(reply, &msg);
+        reply = NULL;
+        if (ret != 0) {
             continue;
         }
         if (msg.ptr && msg.size >= sizeof(app_launcher_msg_t)) {
             if (dispatch(&msg)) {
-                noza_reply(&msg);
+                reply = &msg;
             }
         } else {
-            noza_reply(&msg);
+            reply = &msg;
         }
     }
     return 0;
@@ -8,6 +8,7 @@
 #include "ramfs.h"
 #include "devfs.h"
 #include "launcherfs.h"
+#include "trace_devfs.h"
 #include "drivers/uart/uart_devfs.h"
 #include "printk.h"
 
@@ -55,20 +56,27 @@ static int fs_main(void *param, uint32_t pid)
         printk("fs: devfs init failed (%d)\n", devfs_rc);
     } else {
         uart_register_devfs();
+        trace_register_devfs();
     }
     int launcherfs_rc = launcherfs_mount();
     if (launcherfs_rc != 0) {
         printk("fs: launcherfs mount failed (%d)\n", launcherfs_rc);
     }
 
-    // TODO: spawn worker threads when heavier VFS backends arrive.
+    // a real-time caller should not wait behind background file I/O at our priority
+    noza_port_set_flags(NOZA_PORT_PRIORITY_DONATION);
+
+    // TODO: serve a port object (noza_port_create) from several workers once the VFS is reentrant.
     noza_msg_t msg;
+    noza_msg_t *reply = NULL; // answered by the next noza_reply_recv
     for (;;) {
-        if (noza_recv(&msg) != 0) {
+        int ret = noza_reply_recv(reply, &msg);
+        reply = NULL;
+        if (ret != 0) {
             continue;
         }
         handle_fs_call(&msg);
-        noza_reply(&msg);
+        reply = &msg;
     }
 
     return 0;
@@ -0,0 +1,103 @@
+#include <string.h>
+#include "kernel/noza_config.h"
+#include "nozaos.h"
+#include "posix/errno.h"
+#include "devfs.h"
+#include "trace_devfs.h"
+#include "printk.h"
+
+#if NOZA_OS_ENABLE_TRACE
+typedef struct {
+    uint32_t opens;
+    uint32_t was_on;        // recording state to restore when the last reader closes
+} trace_dev_t;
+
+static trace_dev_t g_trace_dev;
+
+static int trace_dev_open(void *ctx, uint32_t oflag, uint32_t mode, void **dev_handle)
+{
+    (void)oflag;
+    (void)mode;
+    trace_dev_t *dev = (trace_dev_t *)ctx;
+    if (dev->opens == 0) {
+        // the reader's own IPC and syscalls would otherwise refill the rings as fast as it drains
+        int rc = noza_trace_enable(0, &dev->was_on);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    dev->opens++;
+    *dev_handle = dev;
+    return 0;
+}
+
+static int trace_dev_close(void *dev_handle)
+{
+    trace_dev_t *dev = (trace_dev_t *)dev_handle;
+    if (dev->opens > 0 && --dev->opens == 0) {
+        noza_trace_enable(dev->was_on, NULL);
+    }
+    return 0;
+}
+
+static int trace_dev_read(void *dev_handle, void *buf, uint32_t len, uint32_t offset, uint32_t *out_len)
+{
+    (void)dev_handle;
+    (void)offset;
+    if (out_len == NULL) {
+        return EINVAL;
+    }
+    *out_len = 0;
+    if (buf == NULL || len == 0) {
+        return 0;
+    }
+    uint32_t max = len / sizeof(noza_trace_record_t);
+    if (max == 0) {
+        return EINVAL; // whole records only
+    }
+    uint32_t count = 0;
+    int rc = noza_trace_read((noza_trace_record_t *)buf, max, &count);
+    if (rc != 0) {
+        return rc;
+    }
+    *out_len = count * sizeof(noza_trace_record_t);
+    return 0;
+}
+
+static int trace_dev_lseek(void *dev_handle, int64_t offset, int32_t whence, int64_t *new_off)
+{
+    (void)dev_handle;
+    (void)offset;
+    (void)whence;
+    (void)new_off;
+    return ESPIPE;
+}
+
+static const devfs_device_ops_t TRACE_DEV_OPS = {
+    .open = trace_dev_open,
+    .close = trace_dev_close,
+    .read = trace_dev_read,
+    .write = NULL,
+    .lseek = trace_dev_lseek,
+    .ioctl = NULL,
+};
+
+void trace_register_devfs(void)
+{
+    static int registered = 0;
+    if (registered) {
+        return;
+    }
+    int rc = devfs_register_char("trace", 0444, &TRACE_DEV_OPS, &g_trace_dev);
+    if (rc != 0) {
+        printk("[devfs] register /dev/trace failed rc=%d\n", rc);
+        return;
+    }
+    printk("[devfs] /dev/trace ready\n");
+    registered = 1;
+}
+#else
+void trace_register_devfs(void)
+{
+}
+#endif
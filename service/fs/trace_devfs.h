@@ -0,0 +1,5 @@
+#pragma once
+
+// Register /dev/trace, a read-only stream of noza_trace_record_t drained from the
+// kernel trace rings. Recording pauses while the node is open so a drain ends.
+void trace_register_devfs(void);
@@ -82,12 +82,15 @@ static int do_irq_service(void *param, uint32_t pid)
     memset(subscriber_vid, 0, sizeof(subscriber_vid));
 
     noza_msg_t msg;
+    noza_msg_t *reply = NULL; // answered by the next noza_reply_recv
     for (;;) {
-        if (noza_recv(&msg) != 0) {
+        int ret = noza_reply_recv(reply, &msg);
+        reply = NULL;
+        if (ret != 0) {
             continue;
         }
         if (msg.ptr == NULL) {
-            noza_reply(&msg);
+            reply = &msg;
             continue;
         }
 
@@ -98,9 +101,9 @@ static int do_irq_service(void *param, uint32_t pid)
         } else if (msg.size == sizeof(noza_irq_service_msg_t)) {
             noza_irq_service_msg_t *cmd = (noza_irq_service_msg_t *)msg.ptr;
             handle_command(cmd, msg.to_vid);
-            noza_reply(&msg);
+            reply = &msg;
         } else {
-            noza_reply(&msg);
+            reply = &msg;
         }
     }
     return 0;
@@ -36,15 +36,17 @@ void *noza_malloc(size_t size)
     if (ensure_memory_vid(&target_vid) != 0) {
         return malloc(size);
     }
-    mem_msg_t msg = {.cmd = MEMORY_MALLOC, .size = size, .ptr = NULL, .code = 0};
-    noza_msg_t noza_msg = {.to_vid = target_vid, .ptr = (void *)&msg, .size = sizeof(msg)};
+    // mem_msg_t is four words, the request and reply travel in registers
+    noza_msg_t noza_msg = {.to_vid = target_vid, .size = NOZA_MSG_SHORT,
+        .word = {MEMORY_MALLOC, size, 0, 0}};
     int ret = noza_call(&noza_msg);
     if (ret != 0) {
         memory_vid = 0;
         return malloc(size);
     }
-    if (msg.code == MEMORY_SUCCESS) {
-        return msg.ptr;
+    mem_msg_t *msg = (mem_msg_t *)noza_msg.word;
+    if (msg->code == MEMORY_SUCCESS) {
+        return msg->ptr;
     }
     return NULL;
 }
@@ -56,8 +58,8 @@ void noza_free(void *ptr)
         free(ptr);
         return;
     }
-    mem_msg_t msg = {.cmd = MEMORY_FREE, .size = 0, .ptr = ptr, .code = 0};
-    noza_msg_t noza_msg = {.to_vid = target_vid, .ptr = (void *)&msg, .size = sizeof(msg)};
+    noza_msg_t noza_msg = {.to_vid = target_vid, .size = NOZA_MSG_SHORT,
+        .word = {MEMORY_FREE, 0, (uint32_t)(uintptr_t)ptr, 0}};
     if (noza_call(&noza_msg) != 0) {
         memory_vid = 0;
         free(ptr);
@@ -51,6 +51,7 @@ static int do_memory_server(void *param, uint32_t pid)
     (void)param;
     (void)pid;
     noza_msg_t msg;
+    noza_msg_t *reply = NULL; // answered by the next noza_reply_recv
 
     void *service_heap_limit = memory_service_heap_limit();
     ta_init(&tinyalloc, heap_end, service_heap_limit, 256, 16, 8);
@@ -63,7 +64,12 @@ static int do_memory_server(void *param, uint32_t pid)
     }
 
     for (;;) {
-        if ((ret = noza_recv(&msg)) == 0) { // the pid in msg is the sender pid
+        ret = noza_reply_recv(reply, &msg);
+        reply = NULL;
+        if (ret == 0) { // the pid in msg is the sender pid
+            if (msg.size == NOZA_MSG_SHORT) {
+                msg.ptr = msg.word; // the request arrived in registers, reply the same way
+            }
 			mem_msg_t *mem_msg = (mem_msg_t *)msg.ptr;
 			// process the request
 			switch (mem_msg->cmd) {
@@ -88,7 +94,7 @@ static int do_memory_server(void *param, uint32_t pid)
 					mem_msg->code = MEMORY_INVALID_OP;
 					break;
 			}
-		    noza_reply(&msg); // reply
+		    reply = &msg; // reply with the next receive
         }
     }
     return 0;
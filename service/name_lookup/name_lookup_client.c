@@ -18,6 +18,39 @@ int name_lookup_register(const char *name, uint32_t *service_id)
     return msg.code;
 }
 
+// callers resolving name get the port id and reach whichever worker receives on it
+int name_lookup_register_port(const char *name, uint32_t port_id, uint32_t *service_id)
+{
+    uint32_t requested_id = service_id ? *service_id : 0;
+    name_msg_t msg = {.cmd = NAME_LOOKUP_REGISTER_PORT, .name = name, .service_id = requested_id, .vid = port_id};
+    noza_msg_t noza_msg = {.to_vid = NAME_SERVER_VID, .ptr = (void *)&msg, .size = sizeof(msg)};
+    int ret = noza_call(&noza_msg);
+    if (ret != 0) {
+        return ret;
+    }
+    if (msg.code == NAME_LOOKUP_OK && service_id) {
+        *service_id = msg.service_id;
+    }
+    return msg.code;
+}
+
+// threads share one address space, so a channel is found by the address of its control block
+int name_lookup_register_channel(const char *name, void *channel, uint32_t *service_id)
+{
+    uint32_t requested_id = service_id ? *service_id : 0;
+    name_msg_t msg = {.cmd = NAME_LOOKUP_REGISTER_CHANNEL, .name = name, .service_id = requested_id,
+        .vid = (uint32_t)(uintptr_t)channel};
+    noza_msg_t noza_msg = {.to_vid = NAME_SERVER_VID, .ptr = (void *)&msg, .size = sizeof(msg)};
+    int ret = noza_call(&noza_msg);
+    if (ret != 0) {
+        return ret;
+    }
+    if (msg.code == NAME_LOOKUP_OK && service_id) {
+        *service_id = msg.service_id;
+    }
+    return msg.code;
+}
+
 int name_lookup_resolve(const char *name, uint32_t *service_id, uint32_t *vid)
 {
     name_msg_t msg = {
@@ -55,6 +88,20 @@ int name_lookup_resolve_id(uint32_t service_id, uint32_t *vid)
     return msg.code;
 }
 
+int name_lookup_resolve_channel(const char *name, void **channel)
+{
+    name_msg_t msg = {.cmd = NAME_LOOKUP_RESOLVE_CHANNEL, .name = name};
+    noza_msg_t noza_msg = {.to_vid = NAME_SERVER_VID, .ptr = (void *)&msg, .size = sizeof(msg)};
+    int ret = noza_call(&noza_msg);
+    if (ret != 0) {
+        return ret;
+    }
+    if (msg.code == NAME_LOOKUP_OK && channel) {
+        *channel = (void *)(uintptr_t)msg.vid;
+    }
+    return msg.code;
+}
+
 int name_lookup_unregister(uint32_t service_id)
 {
     name_msg_t msg = {.cmd = NAME_LOOKUP_UNREGISTER, .service_id = service_id};
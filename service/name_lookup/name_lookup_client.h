@@ -3,6 +3,9 @@
 #include "name_lookup_server.h"
 
 int name_lookup_register(const char *name, uint32_t *service_id);
+int name_lookup_register_port(const char *name, uint32_t port_id, uint32_t *service_id);
+int name_lookup_register_channel(const char *name, void *channel, uint32_t *service_id);
 int name_lookup_resolve(const char *name, uint32_t *service_id, uint32_t *vid);
 int name_lookup_resolve_id(uint32_t service_id, uint32_t *vid);
+int name_lookup_resolve_channel(const char *name, void **channel);
 int name_lookup_unregister(uint32_t service_id);
@@ -44,11 +44,18 @@ static void map_init(simap_t *m, node_mgr_t *node_mgr) {
     m->alloc_param = node_mgr;
 }
 
+// a name is bound either to a vid/port id or to a channel address, never resolved as the other
+enum {
+    BINDING_SERVICE = 0,
+    BINDING_CHANNEL,
+};
+
 typedef struct {
     uint32_t service_id;
     uint32_t vid;
     char name[MAX_NAME_LEN+1];
     uint8_t in_use;
+    uint8_t kind;
 } service_binding_t;
 
 static service_binding_t service_table[NOZA_MAX_SERVICE];
@@ -62,6 +69,7 @@ static service_binding_t *binding_alloc(void)
             service_table[i].service_id = 0;
             service_table[i].vid = 0;
             service_table[i].name[0] = '\0';
+            service_table[i].kind = BINDING_SERVICE;
             return &service_table[i];
         }
     }
@@ -131,7 +139,7 @@ static service_binding_t *binding_by_name(const char *name)
     return NULL;
 }
 
-static int handle_register(name_msg_t *name_msg, uint32_t caller_vid, simap_t *map)
+static int handle_register(name_msg_t *name_msg, uint32_t target_vid, uint8_t kind, simap_t *map)
 {
     if (!validate_name(name_msg->name)) {
         return NAME_LOOKUP_ERR_INVALID;
@@ -140,10 +148,10 @@ static int handle_register(name_msg_t *name_msg, uint32_t caller_vid, simap_t *m
     // Update existing entry by name
     service_binding_t *binding = binding_by_name(name_msg->name);
     if (binding) {
-        if (name_msg->service_id != 0 && name_msg->service_id != binding->service_id) {
+        if ((name_msg->service_id != 0 && name_msg->service_id != binding->service_id) || binding->kind != kind) {
             return NAME_LOOKUP_ERR_DUPLICATE;
         }
-        binding->vid = caller_vid;
+        binding->vid = target_vid;
         name_msg->service_id = binding->service_id;
         return NAME_LOOKUP_OK;
     }
@@ -167,7 +175,8 @@ static int handle_register(name_msg_t *name_msg, uint32_t caller_vid, simap_t *m
     }
 
     binding->service_id = name_msg->service_id;
-    binding->vid = caller_vid;
+    binding->vid = target_vid;
+    binding->kind = kind;
     strncpy(binding->name, name_msg->name, MAX_NAME_LEN);
     binding->name[MAX_NAME_LEN] = '\0';
 
@@ -177,7 +186,7 @@ static int handle_register(name_msg_t *name_msg, uint32_t caller_vid, simap_t *m
     return NAME_LOOKUP_OK;
 }
 
-static int handle_resolve_name(name_msg_t *name_msg, simap_t *map)
+static int handle_resolve_name(name_msg_t *name_msg, uint8_t kind, simap_t *map)
 {
     (void)map;
     if (!validate_name(name_msg->name)) {
@@ -185,7 +194,7 @@ static int handle_resolve_name(name_msg_t *name_msg, simap_t *map)
     }
 
     service_binding_t *binding = binding_by_name(name_msg->name);
-    if (binding == NULL) {
+    if (binding == NULL || binding->kind != kind) {
         return NAME_LOOKUP_ERR_NOT_FOUND;
     }
 
@@ -197,7 +206,7 @@ static int handle_resolve_name(name_msg_t *name_msg, simap_t *map)
 static int handle_resolve_id(name_msg_t *name_msg)
 {
     service_binding_t *binding = binding_by_id(name_msg->service_id);
-    if (binding == NULL) {
+    if (binding == NULL || binding->kind != BINDING_SERVICE) {
         return NAME_LOOKUP_ERR_NOT_FOUND;
     }
     name_msg->vid = binding->vid;
@@ -228,6 +237,7 @@ static int handle_unregister(name_msg_t *name_msg, simap_t *map)
 static int do_name_server(void *param, uint32_t pid)
 {
     noza_msg_t msg;
+    noza_msg_t *reply = NULL; // answered by the next noza_reply_recv
     simap_t map;
     static node_mgr_t node_mgr;
 
@@ -239,20 +249,42 @@ static int do_name_server(void *param, uint32_t pid)
     map_init(&map, &node_mgr);
     simap_init(&map, node_alloc, node_free, &node_mgr);
     for (;;) {
-        if (noza_recv(&msg) == 0) {
+        int ret = noza_reply_recv(reply, &msg);
+        reply = NULL;
+        if (ret == 0) {
             name_msg_t *name_msg = (name_msg_t *)msg.ptr;
             if (msg.size < sizeof(name_msg_t)) {
                 name_msg->code = NAME_LOOKUP_ERR_INVALID;
-                noza_reply(&msg);
+                reply = &msg;
                 continue;
             }
             switch (name_msg->cmd) {
                 case NAME_LOOKUP_REGISTER:
-                    name_msg->code = handle_register(name_msg, msg.to_vid, &map);
+                    name_msg->code = handle_register(name_msg, msg.to_vid, BINDING_SERVICE, &map);
+                    break;
+
+                case NAME_LOOKUP_REGISTER_PORT:
+                    if (!NOZA_PORT_IS_ID(name_msg->vid)) {
+                        name_msg->code = NAME_LOOKUP_ERR_INVALID;
+                        break;
+                    }
+                    name_msg->code = handle_register(name_msg, name_msg->vid, BINDING_SERVICE, &map);
+                    break;
+
+                case NAME_LOOKUP_REGISTER_CHANNEL:
+                    if (name_msg->vid == 0) {
+                        name_msg->code = NAME_LOOKUP_ERR_INVALID;
+                        break;
+                    }
+                    name_msg->code = handle_register(name_msg, name_msg->vid, BINDING_CHANNEL, &map);
                     break;
 
                 case NAME_LOOKUP_RESOLVE_NAME:
-                    name_msg->code = handle_resolve_name(name_msg, &map);
+                    name_msg->code = handle_resolve_name(name_msg, BINDING_SERVICE, &map);
+                    break;
+
+                case NAME_LOOKUP_RESOLVE_CHANNEL:
+                    name_msg->code = handle_resolve_name(name_msg, BINDING_CHANNEL, &map);
                     break;
 
                 case NAME_LOOKUP_RESOLVE_ID:
@@ -267,7 +299,7 @@ static int do_name_server(void *param, uint32_t pid)
                     name_msg->code = NAME_LOOKUP_ERR_INVALID;
                     break;
             }
-            noza_reply(&msg);
+            reply = &msg;
         }
     }
 
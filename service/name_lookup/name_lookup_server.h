@@ -10,6 +10,9 @@ enum {
 	NAME_LOOKUP_RESOLVE_NAME,
 	NAME_LOOKUP_RESOLVE_ID,
 	NAME_LOOKUP_UNREGISTER,
+	NAME_LOOKUP_REGISTER_PORT,	// bind the name to the port object in vid
+	NAME_LOOKUP_REGISTER_CHANNEL,	// bind the name to the shared-memory channel at address vid
+	NAME_LOOKUP_RESOLVE_CHANNEL,	// channel address of the name in vid
 };
 
 enum {
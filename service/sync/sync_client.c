@@ -48,6 +48,18 @@ static int sync_call(noza_msg_t *msg)
 	return ret;
 }
 
+// a mutex request is four words, so it travels in registers both ways
+static int mutex_call(mutex_msg_t *msg)
+{
+	noza_msg_t noza_msg = {.size = NOZA_MSG_SHORT};
+	memcpy(noza_msg.word, msg, sizeof(*msg));
+	int ret = sync_call(&noza_msg);
+	if (ret == 0) {
+		memcpy(msg, noza_msg.word, sizeof(*msg));
+	}
+	return ret;
+}
+
 static inline int sync_result(int ret, uint32_t code)
 {
 	return ret != 0 ? ret : (int)code;
@@ -56,8 +68,7 @@ static inline int sync_result(int ret, uint32_t code)
 int mutex_acquire(mutex_t *mutex)
 {
 	mutex_msg_t msg = {.cmd = MUTEX_ACQUIRE, .mid = mutex->mid, .token = 0, .code = 0};
-	noza_msg_t noza_msg = {.ptr = (void *)&msg, .size = sizeof(msg)};
-	int ret = sync_call(&noza_msg);
+	int ret = mutex_call(&msg);
 	if (ret != 0) {
 		return ret;
 	}
@@ -71,32 +82,28 @@ int mutex_acquire(mutex_t *mutex)
 int mutex_release(mutex_t *mutex)
 {
 	mutex_msg_t msg = {.cmd = MUTEX_RELEASE, .mid = mutex->mid, .token = mutex->token, .code = 0};
-	noza_msg_t noza_msg = {.ptr = (void *)&msg, .size = sizeof(msg)};
-	int ret = sync_call(&noza_msg);
+	int ret = mutex_call(&msg);
 	return sync_result(ret, msg.code);
 }
 
 int mutex_lock(mutex_t *mutex)
 {
 	mutex_msg_t msg = {.cmd = MUTEX_LOCK, .mid = mutex->mid, .token = mutex->token, .code = 0};
-	noza_msg_t noza_msg = {.ptr = (void *)&msg, .size = sizeof(msg)};
-	int ret = sync_call(&noza_msg);
+	int ret = mutex_call(&msg);
 	return sync_result(ret, msg.code);
 }
 
 int mutex_trylock(mutex_t *mutex)
 {
 	mutex_msg_t msg = {.cmd = MUTEX_TRYLOCK, .mid = mutex->mid, .token = mutex->token, .code = 0};
-	noza_msg_t noza_msg = {.ptr = (void *)&msg, .size = sizeof(msg)};
-	int ret = sync_call(&noza_msg);
+	int ret = mutex_call(&msg);
 	return sync_result(ret, msg.code);
 }
 
 int mutex_unlock(mutex_t *mutex)
 {
 	mutex_msg_t msg = {.cmd = MUTEX_UNLOCK, .mid = mutex->mid, .token = mutex->token };
-	noza_msg_t noza_msg = {.ptr = (void *)&msg, .size = sizeof(msg)};
-	int ret = sync_call(&noza_msg);
+	int ret = mutex_call(&msg);
 	return sync_result(ret, msg.code);
 }
 
@@ -46,6 +46,24 @@ typedef struct {
 	pending_node_t	pending_store[MAX_PENDING];
 } sync_info_t;
 
+// the reply to the request being served goes out with the next noza_reply_recv, so the
+// main loop costs one trap per request; parked requests are answered with noza_reply
+static noza_msg_t *deferred_reply;
+
+static inline void sync_reply(noza_msg_t *msg)
+{
+	deferred_reply = msg;
+}
+
+// park a request; a register-carried request keeps its payload in the parked copy
+static inline void save_pending(pending_node_t *pm, noza_msg_t *msg)
+{
+	pm->noza_msg = *msg;
+	if (pm->noza_msg.size == NOZA_MSG_SHORT) {
+		pm->noza_msg.ptr = pm->noza_msg.word;
+	}
+}
+
 static inline void mutex_insert_pending_tail(mutex_item_t *mutex, pending_node_t *pm)
 {
 	mutex->pending = (pending_node_t *)dblist_insert_tail(
@@ -103,7 +121,7 @@ static void mutex_server_acquire(noza_msg_t *msg, sync_info_t *si)
 	if (si->mutex_head == NULL) {
 		printk("mutex: no more resource\n");
 		mutex_msg->code = MUTEX_NOT_ENOUGH_RESOURCE;
-		noza_reply(msg);
+		sync_reply(msg);
 		return;
 	}
 	// update the message structure
@@ -119,7 +137,7 @@ static void mutex_server_acquire(noza_msg_t *msg, sync_info_t *si)
 		printk("mutex: unlikely be here....\n");
 	}
 	si->mutex_head = (mutex_item_t *)dblist_remove_head((dblink_item_t *)si->mutex_head); // move head to next
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void mutex_server_release(mutex_item_t *working_mutex, noza_msg_t *msg, sync_info_t *si)
@@ -136,7 +154,7 @@ static void mutex_server_release(mutex_item_t *working_mutex, noza_msg_t *msg, s
 	working_mutex->lock = 0; // clear lock
 	si->mutex_head = (mutex_item_t *)dblist_insert_tail((dblink_item_t *)si->mutex_head, &working_mutex->link);
 	mutex_msg->code = MUTEX_SUCCESS; // success
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void mutex_server_lock(mutex_item_t *working_mutex, noza_msg_t *msg, sync_info_t *si)
@@ -145,16 +163,16 @@ static void mutex_server_lock(mutex_item_t *working_mutex, noza_msg_t *msg, sync
 	if (working_mutex->lock == 0) {
 		working_mutex->lock = 1; // lock
 		mutex_msg->code = MUTEX_SUCCESS;
-		noza_reply(msg); // the lock is free, lock it and return immediately
+		sync_reply(msg); // the lock is free, lock it and return immediately
 	} else {
 		pending_node_t *pm = get_free_pending(si);
 		if (pm == NULL) {
 			mutex_msg->code = MUTEX_NOT_ENOUGH_RESOURCE;
 			printk("mutex: no more free pending slot, just lock and reply\n");
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
-		pm->noza_msg = *msg; // copy message
+		save_pending(pm, msg); // copy message
 		mutex_insert_pending_tail(working_mutex, pm);
 	}
 }
@@ -169,7 +187,7 @@ static void mutex_server_trylock(mutex_item_t *working_mutex, noza_msg_t *msg, s
 	} else {
 		mutex_msg->code = MUTEX_LOCK_FAIL;
 	}
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void mutex_server_unlock(mutex_item_t *working_mutex, noza_msg_t *msg, sync_info_t *si)
@@ -185,14 +203,14 @@ static void mutex_server_unlock(mutex_item_t *working_mutex, noza_msg_t *msg, sy
 		insert_free_padding_tail(si, pending);
 		if (mutex_msg) {
 			mutex_msg->code = MUTEX_SUCCESS; // reply success
-			noza_reply(msg);
+			sync_reply(msg);
 		}
 	} else {
 		// there is no pending request, unlock the request
 		working_mutex->lock = 0;
 		if (mutex_msg) {
 			mutex_msg->code = MUTEX_SUCCESS;
-			noza_reply(msg);
+			sync_reply(msg);
 		}
 	}
 }
@@ -206,7 +224,7 @@ static void process_mutex(noza_msg_t *msg, sync_info_t *si)
 		if (mutex_msg->mid >= MAX_LOCKS) {
 			printk("mutex invalid id: %d\n", mutex_msg->mid);
 			mutex_msg->code = MUTEX_INVALID_ID;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 
@@ -214,7 +232,7 @@ static void process_mutex(noza_msg_t *msg, sync_info_t *si)
 		if (working_mutex->token != mutex_msg->token) {
 			printk("mutex token mismatch service:%d != client:%d\n", working_mutex->token, mutex_msg->token);
 			mutex_msg->code = MUTEX_INVALID_TOKEN;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 	}
@@ -243,7 +261,7 @@ static void process_mutex(noza_msg_t *msg, sync_info_t *si)
 
 		default:
 			mutex_msg->code = INVALID_OP;
-			noza_reply(msg);
+			sync_reply(msg);
 			break;
 	}
 }
@@ -254,7 +272,7 @@ static void cond_server_acquire(noza_msg_t *msg, sync_info_t *si)
 	if (si->cond_head == NULL) {
 		printk("cond: no more resource\n");
 		cond_msg->code = COND_NOT_ENOUGH_RESOURCE;
-		noza_reply(msg);
+		sync_reply(msg);
 		return;
 	}
 	// update the message structure
@@ -270,7 +288,7 @@ static void cond_server_acquire(noza_msg_t *msg, sync_info_t *si)
 		printk("unlikely be here....\n");
 	}
 	si->cond_head = (cond_item_t *)dblist_remove_head((dblink_item_t *)si->cond_head); // move head to next
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void cond_server_release(cond_item_t *working_cond, noza_msg_t *msg, sync_info_t *si)
@@ -287,7 +305,7 @@ static void cond_server_release(cond_item_t *working_cond, noza_msg_t *msg, sync
 	working_cond->signaled = 0; // clear signal
 	si->cond_head = (cond_item_t *)dblist_insert_tail((dblink_item_t *)si->cond_head, &working_cond->link);
 	cond_msg->code = COND_SUCCESS; // success
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void cond_server_wait(cond_item_t *working_cond, noza_msg_t *msg, sync_info_t *si)
@@ -297,12 +315,12 @@ static void cond_server_wait(cond_item_t *working_cond, noza_msg_t *msg, sync_in
 		// already signaled, return immediately
 		working_cond->signaled = 0;
 		cond_msg->code = COND_SUCCESS;
-		noza_reply(msg);
+		sync_reply(msg);
 	} else {
 		if (cond_msg->mid >= MAX_LOCKS) {
 			printk("cond invalid id: %d\n", cond_msg->mid);
 			cond_msg->code = COND_INVALID_ID;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 
@@ -310,7 +328,7 @@ static void cond_server_wait(cond_item_t *working_cond, noza_msg_t *msg, sync_in
 		if (cond_msg->mtoken != working_mutex->token) {
 			printk("cond invalid mutex token\n");
 			cond_msg->code = COND_INVALID_TOKEN;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 
@@ -320,9 +338,9 @@ static void cond_server_wait(cond_item_t *working_cond, noza_msg_t *msg, sync_in
 		if (pm == NULL) {
 			cond_msg->code = COND_NOT_ENOUGH_RESOURCE;
 			printk("cond: no more free pending slot, just lock and reply\n");
-			noza_reply(msg);
+			sync_reply(msg);
 		} else {
-			pm->noza_msg = *msg; // copy message
+			save_pending(pm, msg); // copy message
 			// insert into pending list
 			working_cond->pending = (pending_node_t *)dblist_insert_tail(
 				working_cond->pending ? &working_cond->pending->link : NULL, &pm->link);
@@ -359,10 +377,10 @@ static void cond_server_signal(cond_item_t *working_cond, noza_msg_t *msg, sync_
 					if (pm == NULL) {
 						cond_msg->code = COND_NOT_ENOUGH_RESOURCE;
 						printk("cond: no more free pending slot, just reply\n");
-						noza_reply(msg);
+						sync_reply(msg);
 						return;
 					}
-					pm->noza_msg = *msg; // copy message, and insert into user mutex's pending list
+					save_pending(pm, msg); // copy message, and insert into user mutex's pending list
 					mutex_insert_pending_tail(user_mutex, pm);
 					return;	
 				} else {
@@ -383,7 +401,7 @@ static void cond_server_signal(cond_item_t *working_cond, noza_msg_t *msg, sync_
 	}
 	// reply success to caller
 	cond_msg->code = COND_SUCCESS;
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void process_cond(noza_msg_t *msg, sync_info_t *si)
@@ -395,7 +413,7 @@ static void process_cond(noza_msg_t *msg, sync_info_t *si)
 		if (cond_msg->cid >= MAX_CONDS) {
 			printk("ond invalid id: %d\n", cond_msg->cid);
 			cond_msg->code = COND_INVALID_ID;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 
@@ -403,7 +421,7 @@ static void process_cond(noza_msg_t *msg, sync_info_t *si)
 		if (working_cond->ctoken != cond_msg->ctoken) {
 			printk("cond token mismatch service:%d != client:%d\n", working_cond->ctoken, cond_msg->ctoken);
 			cond_msg->code = MUTEX_INVALID_TOKEN;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 	}
@@ -431,7 +449,7 @@ static void process_cond(noza_msg_t *msg, sync_info_t *si)
 
 		default:
 			cond_msg->code = INVALID_OP;
-			noza_reply(msg);
+			sync_reply(msg);
 			break;
 	}
 }
@@ -443,7 +461,7 @@ static void sem_server_acquire(sem_item_t *working_sem, noza_msg_t *msg, sync_in
 	if (si->sem_head == NULL) {
 		printk("sem: no more resource\n");
 		sem_msg->code = SEM_NOT_ENOUGH_RESOURCE;
-		noza_reply(msg);
+		sync_reply(msg);
 		return;
 	}
 
@@ -460,7 +478,7 @@ static void sem_server_acquire(sem_item_t *working_sem, noza_msg_t *msg, sync_in
 		printk("sem: unlikely be here....\n");
 	}
 	si->sem_head = (sem_item_t *)dblist_remove_head((dblink_item_t *)si->sem_head); // move head to next
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void sem_server_release(sem_item_t *working_sem, noza_msg_t *msg, sync_info_t *si)
@@ -477,7 +495,7 @@ static void sem_server_release(sem_item_t *working_sem, noza_msg_t *msg, sync_in
 	working_sem->value = 0; // clear value
 	si->sem_head = (sem_item_t *)dblist_insert_tail((dblink_item_t *)si->sem_head, &working_sem->link);
 	sem_msg->code = SEM_SUCCESS; // success
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void sem_server_wait(sem_item_t *working_sem, noza_msg_t *msg, sync_info_t *si)
@@ -486,12 +504,12 @@ static void sem_server_wait(sem_item_t *working_sem, noza_msg_t *msg, sync_info_
 	if (working_sem->value > 0) {
 		working_sem->value--;
 		sem_msg->code = SEM_SUCCESS;
-		noza_reply(msg);
+		sync_reply(msg);
 	} else {
 		if (sem_msg->sid >= MAX_SEMS) {
 			printk("sem invalid id: %d\n", sem_msg->sid);
 			sem_msg->code = SEM_INVALID_ID;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 
@@ -499,7 +517,7 @@ static void sem_server_wait(sem_item_t *working_sem, noza_msg_t *msg, sync_info_
 		if (sem_msg->stoken != working_sem->stoken) {
 			printk("sem invalid token\n");
 			sem_msg->code = SEM_INVALID_TOKEN;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 
@@ -507,9 +525,9 @@ static void sem_server_wait(sem_item_t *working_sem, noza_msg_t *msg, sync_info_
 		if (pm == NULL) {
 			sem_msg->code = SEM_NOT_ENOUGH_RESOURCE;
 			printk("sem: no more free pending slot\n");
-			noza_reply(msg);
+			sync_reply(msg);
 		} else {
-			pm->noza_msg = *msg; // copy message
+			save_pending(pm, msg); // copy message
 			sem_insert_pending_tail(working_sem, pm);
 		}
 	}
@@ -525,7 +543,7 @@ static void sem_server_trywait(sem_item_t *working_sem, noza_msg_t *msg, sync_in
 	} else {
 		sem_msg->code = SEM_TRYWAIT_FAIL;
 	}
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void sem_server_post(sem_item_t *working_sem, noza_msg_t *msg, sync_info_t *si)
@@ -542,7 +560,7 @@ static void sem_server_post(sem_item_t *working_sem, noza_msg_t *msg, sync_info_
 		working_sem->value++;
 	}
 	sem_msg->code = SEM_SUCCESS;
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void sem_server_getvalue(sem_item_t *working_sem, noza_msg_t *msg, sync_info_t *si)
@@ -551,7 +569,7 @@ static void sem_server_getvalue(sem_item_t *working_sem, noza_msg_t *msg, sync_i
 	sem_msg_t *sem_msg = (sem_msg_t *)msg->ptr;
 	sem_msg->value = working_sem->value;
 	sem_msg->code = SEM_SUCCESS;
-	noza_reply(msg);
+	sync_reply(msg);
 }
 
 static void process_sem(noza_msg_t *msg, sync_info_t *si)
@@ -563,7 +581,7 @@ static void process_sem(noza_msg_t *msg, sync_info_t *si)
 		if (sem_msg->sid >= MAX_SEMS) {
 			printk("sem invalid id: %d\n", sem_msg->sid);
 			sem_msg->code = SEM_INVALID_ID;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 
@@ -572,7 +590,7 @@ static void process_sem(noza_msg_t *msg, sync_info_t *si)
 			printk("sem token mismatch service:%d != client:%d\n",
 				working_sem->stoken, sem_msg->stoken);
 			sem_msg->code = MUTEX_INVALID_TOKEN;
-			noza_reply(msg);
+			sync_reply(msg);
 			return;
 		}
 	}
@@ -604,7 +622,7 @@ static void process_sem(noza_msg_t *msg, sync_info_t *si)
 
 		default:
 			sem_msg->code = INVALID_OP;
-			noza_reply(msg);
+			sync_reply(msg);
 			break;
 	}
 }
@@ -641,7 +659,12 @@ static int do_synchorization_server(void *param, uint32_t pid)
 
     noza_msg_t msg;
     for (;;) {
-        if (noza_recv(&msg) == 0) {
+        noza_msg_t *reply = deferred_reply;
+        deferred_reply = NULL;
+        if (noza_reply_recv(reply, &msg) == 0) {
+			if (msg.size == NOZA_MSG_SHORT) {
+				msg.ptr = msg.word; // mutex requests arrive in registers
+			}
 			packet_t *packet = (packet_t *)msg.ptr;
 			if (packet->cmd < MUTEX_TAIL) {
 				process_mutex(&msg, &si);
@@ -651,7 +674,7 @@ static int do_synchorization_server(void *param, uint32_t pid)
 				process_sem(&msg, &si);
 			} else {
 				packet->code = INVALID_OP;
-				noza_reply(&msg);
+				sync_reply(&msg);
 			}
         }
     }
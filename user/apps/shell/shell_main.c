@@ -22,6 +22,8 @@
 
 #define SHELL_BANNER "\nNOZA OS v0.01\n"
 #define SHELL_PROMPT_FMT "noza(%u)> "
+#define SHELL_PS_THREAD_BATCH 8
+#define SHELL_TRACE_BATCH 8
 
 static int shell_tty_fd = -1;
 static uint32_t shell_prompt_counter = 0;
@@ -149,10 +151,9 @@ static void shell_print_identity(void)
 {
     uint32_t pid = 0;
     if (noza_thread_self(&pid) != 0) {
-        extern uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
         uint32_t core = platform_get_running_core();
         if (core < NOZA_OS_NUM_CORES) {
-            pid = NOZAOS_PID[core];
+            pid = noza_kdata.core[core].vid;
         }
     }
     if (pid != 0) {
@@ -258,6 +259,34 @@ static const char *shell_proc_state_name(uint32_t state)
     }
 }
 
+static const char *shell_thread_state_name(uint32_t state)
+{
+    switch (state) {
+    case NOZA_THREAD_STATE_RUNNING:
+        return "RUN";
+    case NOZA_THREAD_STATE_READY:
+        return "READY";
+    case NOZA_THREAD_STATE_WAITING_MSG:
+    case NOZA_THREAD_STATE_WAITING_READ:
+    case NOZA_THREAD_STATE_WAITING_REPLY:
+        return "IPC";
+    case NOZA_THREAD_STATE_WAITING_SYNC:
+        return "SYNC";
+    case NOZA_THREAD_STATE_SLEEP:
+        return "SLEEP";
+    case NOZA_THREAD_STATE_ZOMBIE:
+        return "ZOMB";
+    case NOZA_THREAD_STATE_PENDING_JOIN:
+        return "JOIN";
+    case NOZA_THREAD_STATE_STOPPED:
+        return "STOP";
+    case NOZA_THREAD_STATE_THROTTLED:
+        return "THROT";
+    default:
+        return "UNK";
+    }
+}
+
 static int shell_parse_u32(const char *text, uint32_t *value)
 {
     uint32_t result = 0;
@@ -366,6 +395,59 @@ static void shell_show_processes(void)
         offset += msg->proc_list.count;
     }
     noza_free(msg);
+
+    noza_thread_stat_t stats[SHELL_PS_THREAD_BATCH];
+    app_printf("\nTID        PRI CPU STATE  TIME(ms)   VCSW     ICSW     SYSCALLS\n");
+    offset = 0;
+    for (;;) {
+        uint32_t count = 0;
+        int rc = noza_thread_stats(stats, SHELL_PS_THREAD_BATCH, offset, &count);
+        if (rc != 0) {
+            app_printf("ps: thread stats failed (%d)\n", rc);
+            break;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            noza_thread_stat_t *st = &stats[i];
+            app_printf(
+                "%-10u %-3u %-3u %-6s %-10u %-8u %-8u %u\n",
+                (unsigned)st->vid,
+                (unsigned)st->priority,
+                (unsigned)st->last_core,
+                shell_thread_state_name(st->state),
+                (unsigned)(st->run_us / 1000),
+                (unsigned)st->voluntary_switches,
+                (unsigned)st->involuntary_switches,
+                (unsigned)st->syscalls);
+        }
+        if (count < SHELL_PS_THREAD_BATCH) {
+            break;
+        }
+        offset += count;
+    }
+}
+
+// drain /dev/trace as hex lines that scripts/noza_trace.py picks out of a console log
+static void shell_trace_command(void)
+{
+    int fd = open("/dev/trace", O_RDONLY, 0);
+    if (fd < 0) {
+        app_printf("trace: cannot open /dev/trace\n");
+        return;
+    }
+    noza_trace_record_t recs[SHELL_TRACE_BATCH];
+    uint32_t total = 0;
+    int r;
+    while ((r = read(fd, recs, sizeof(recs))) > 0) {
+        uint32_t n = (uint32_t)r / sizeof(noza_trace_record_t);
+        for (uint32_t i = 0; i < n; i++) {
+            const uint32_t *w = (const uint32_t *)&recs[i];
+            app_printf("trace: %08x %08x %08x %08x\n",
+                (unsigned)w[0], (unsigned)w[1], (unsigned)w[2], (unsigned)w[3]);
+        }
+        total += n;
+    }
+    close(fd);
+    app_printf("trace: %u records\n", (unsigned)total);
 }
 
 static void shell_wait_command(char *argv[], int argc)
@@ -480,8 +562,10 @@ int shell_main(int argc, char **argv)
             shell_wait_command(args, cmd_argc);
         } else if (strcmp(args[0], "exec") == 0) {
             shell_exec_command(args, cmd_argc);
+        } else if (strcmp(args[0], "trace") == 0) {
+            shell_trace_command();
         } else if (strcmp(args[0], "help") == 0 || strcmp(args[0], "list") == 0) {
-            app_printf("commands: ls [path], cat <file>, mkdir <path>, rm <path>, cd <path>, pwd, pid, ps, kill [-signum] <pid>, wait <pid>, exec <app>\n");
+            app_printf("commands: ls [path], cat <file>, mkdir <path>, rm <path>, cd <path>, pwd, pid, ps, kill [-signum] <pid>, wait <pid>, exec <app>, trace\n");
             app_printf("unknown commands are resolved via /sbin and spawned with posix_spawnp\n");
         } else {
             shell_spawn_command(args);
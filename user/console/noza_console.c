@@ -249,8 +249,11 @@ int console_start()
 		}
 	} else {
 		noza_msg_t msg;
+		noza_msg_t *reply = NULL; // answered by the next noza_reply_recv
 		for (;;) {
-			if (noza_recv(&msg) != 0) {
+			int recv_ret = noza_reply_recv(reply, &msg);
+			reply = NULL;
+			if (recv_ret != 0) {
 				continue;
 			}
 			if (msg.ptr && msg.size == sizeof(noza_irq_event_t)) {
@@ -266,7 +269,7 @@ int console_start()
 					}
 				}
 			} else {
-				noza_reply(&msg);
+				reply = &msg;
 			}
 		}
 	}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+// Shared-memory element rings between threads. Data moves without a trap; a
+// futex doorbell is rung only when the consumer sleeps on an empty ring, a
+// producer sleeps on a full one, or an MPSC producer waits for an earlier claim
+// to be published.
+
+#define NOZA_CHANNEL_MAGIC  0x4e5a4348u   // "NZCH"
+
+#define NOZA_CHANNEL_SPSC   0x00    // one producer, one consumer
+#define NOZA_CHANNEL_MPSC   0x01    // many producers, one consumer
+
+typedef struct {
+    uint32_t magic;
+    uint32_t flags;
+    uint32_t elem_size;
+    uint32_t capacity;                      // in elements, power of two
+    volatile uint32_t head;                 // next slot to consume, owned by the consumer
+    volatile uint32_t tail;                 // end of the published elements, futex word for the consumer
+    volatile uint32_t reserve;              // end of the claimed slots (MPSC)
+    volatile uint32_t consumer_waiting;
+    volatile uint32_t producers_waiting;
+    volatile uint32_t publishers_waiting;   // MPSC producers parked on tail behind an earlier claim
+    uint8_t *data;                          // capacity * elem_size bytes
+} noza_channel_t;
+
+int noza_channel_init(noza_channel_t *ch, void *buffer, uint32_t elem_size, uint32_t capacity, uint32_t flags);
+
+// bind the channel to a name in the name service, or look a published channel up
+int noza_channel_publish(noza_channel_t *ch, const char *name, uint32_t *service_id);
+int noza_channel_open(const char *name, noza_channel_t **ch);
+
+// move up to count elements; blocks only while the ring is full (send) or empty (recv).
+// timeout_us = 0 never blocks, negative waits forever. Returns the number of elements moved,
+// 0 on timeout.
+uint32_t noza_channel_send(noza_channel_t *ch, const void *elems, uint32_t count, int32_t timeout_us);
+uint32_t noza_channel_recv(noza_channel_t *ch, void *elems, uint32_t max, int32_t timeout_us);
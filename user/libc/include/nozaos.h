@@ -5,6 +5,11 @@
 #include <stddef.h>
 #include "noza_ipc.h"
 #include "noza_fs.h"
+#include "noza_futex.h"
+#include "noza_wait.h"
+#include "noza_kdata.h"
+#include "noza_sched.h"
+#include "noza_trace.h"
 #include "spinlock.h"
 
 typedef struct {
@@ -17,6 +22,8 @@ typedef struct {
 #define NOZA_CLOCK_REALTIME     0
 #define NOZA_CLOCK_MONOTONIC    1
 #define NOZA_TIMER_FLAG_PERIODIC 0x01
+#define NOZA_TIMER_FLAG_SLACK   0x02
+#define NOZA_AFFINITY_ANY       0xFFFFFFFFu
 
 // Noza thread & scheduling
 int     noza_thread_sleep_us(int64_t us, int64_t *remain_us);
@@ -25,29 +32,57 @@ int     noza_thread_create(uint32_t *pth, int (*entry)(void *param, uint32_t pid
 int     noza_thread_create_with_stack(uint32_t *pth, int (*entry)(void *param, uint32_t pid), void *param, uint32_t priority, void *stack_addr, uint32_t stack_size, uint32_t auto_free);
 int     noza_thread_kill(uint32_t thread_id, int sig);
 int     noza_thread_change_priority(uint32_t thread_id, uint32_t priority);
+int     noza_thread_set_affinity(uint32_t thread_id, uint32_t core_mask);
+int     noza_thread_set_deadline(uint32_t thread_id, const noza_sched_deadline_t *attr);
+// snapshot up to max live threads, skipping the first offset; *count gets the number filled in
+int     noza_thread_stats(noza_thread_stat_t *stats, uint32_t max, uint32_t offset, uint32_t *count);
+int     noza_lock_stats(noza_lock_stat_t *stats, uint32_t max, uint32_t *count);
 int     noza_thread_detach(uint32_t thread_id);
 int     noza_thread_join(uint32_t thread_id, uint32_t *code);
 void    noza_thread_terminate(int exit_code);
 int     noza_thread_self(uint32_t *pid);
 int     noza_futex_wait(uint32_t *addr, uint32_t expected, int32_t timeout_us);
 int     noza_futex_wake(uint32_t *addr, uint32_t count);
+int     noza_futex_wait_bitset(uint32_t *addr, uint32_t expected, uint32_t bitset, int32_t timeout_us);
+int     noza_futex_wake_bitset(uint32_t *addr, uint32_t count, uint32_t bitset);
+int     noza_futex_requeue(uint32_t *addr, uint32_t wake_count, uint32_t *addr2, uint32_t requeue_count);
+int     noza_futex_cmp_requeue(uint32_t *addr, uint32_t expected, uint32_t wake_count, uint32_t *addr2, uint32_t requeue_count);
+int     noza_futex_wake_op(uint32_t *addr, uint32_t wake_count, uint32_t *addr2, uint32_t wake_count2, uint32_t op);
+int     noza_futex_lock_pi(uint32_t *addr, int32_t timeout_us);
+int     noza_futex_trylock_pi(uint32_t *addr);
+int     noza_futex_unlock_pi(uint32_t *addr);
 
 // Noza message API
 int     noza_recv(noza_msg_t *msg);
 int     noza_call(noza_msg_t *msg);
 int     noza_reply(noza_msg_t *msg);
+int     noza_reply_recv(noza_msg_t *reply, noza_msg_t *msg);
 int     noza_nonblock_call(noza_msg_t *msg);
 int     noza_nonblock_recv(noza_msg_t *msg);
+int     noza_port_set_flags(uint32_t flags);
+int     noza_port_create(uint32_t *port_id);
+int     noza_port_destroy(uint32_t port_id);
+int     noza_port_reply_recv(uint32_t port_id, noza_msg_t *reply, noza_msg_t *msg);
+int     noza_port_recv(uint32_t port_id, noza_msg_t *msg);
+int     noza_call_batch(noza_msg_t *msgs, int32_t *status, uint32_t count);
+int     noza_call_async(noza_msg_t *msg, uint32_t tag);
+int     noza_async_wait(noza_async_result_t *result, int32_t timeout_us);
+int     noza_wait_any(noza_wait_source_t *sources, uint32_t count, int32_t timeout_us);
 uint32_t noza_get_stack_space();
 int     noza_timer_create(uint32_t *timer_id);
 int     noza_timer_delete(uint32_t timer_id);
 int     noza_timer_arm(uint32_t timer_id, uint32_t duration_us, uint32_t flags);
 int     noza_timer_cancel(uint32_t timer_id);
 int     noza_timer_wait(uint32_t timer_id, int32_t timeout_us);
+int     noza_timer_set_slack(uint32_t timer_id, uint32_t slack_us);
 int     noza_clock_gettime(uint32_t clock_id, noza_time64_t *timestamp);
 int     noza_signal_send(uint32_t tid, uint32_t signum);
 uint32_t noza_signal_take(void);
 
+// kernel event trace (ENOSYS when built without NOZA_OS_ENABLE_TRACE)
+int     noza_trace_read(noza_trace_record_t *records, uint32_t max, uint32_t *count);
+int     noza_trace_enable(uint32_t on, uint32_t *was_on);
+
 // user level call
 int noza_set_errno(int err);
 int noza_get_errno();
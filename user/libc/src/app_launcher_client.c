@@ -68,10 +68,9 @@ static uint32_t current_thread_pid(void)
     if (noza_thread_self(&pid) == 0 && pid != 0) {
         return pid;
     }
-    extern uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
     uint32_t core = platform_get_running_core();
     if (core < NOZA_OS_NUM_CORES) {
-        return NOZAOS_PID[core];
+        return noza_kdata.core[core].vid;
     }
     return 0;
 }
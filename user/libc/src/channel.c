@@ -0,0 +1,236 @@
+#include <string.h>
+#include <stdbool.h>
+#include "channel.h"
+#include "nozaos.h"
+#include "posix/errno.h"
+#include "service/name_lookup/name_lookup_client.h"
+
+#define CHANNEL_WAKE_ALL    0xFFFFFFFFu
+
+static int64_t channel_now_us(void)
+{
+    noza_time64_t ts;
+    if (noza_clock_gettime(NOZA_CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    int64_t ns = ((int64_t)ts.high << 32) | ts.low;
+    return ns / 1000;
+}
+
+// remaining futex timeout for a wait that started with timeout_us; -1 keeps waiting forever
+static int32_t channel_remaining(int32_t timeout_us, int64_t deadline_us)
+{
+    if (timeout_us <= 0) {
+        return timeout_us;
+    }
+    int64_t left = deadline_us - channel_now_us();
+    return (left > 0) ? (int32_t)left : 0;
+}
+
+static void channel_copy_in(noza_channel_t *ch, uint32_t pos, const uint8_t *src, uint32_t n)
+{
+    uint32_t idx = pos & (ch->capacity - 1);
+    uint32_t first = ch->capacity - idx;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(ch->data + idx * ch->elem_size, src, first * ch->elem_size);
+    if (n > first) {
+        memcpy(ch->data, src + first * ch->elem_size, (n - first) * ch->elem_size);
+    }
+}
+
+static void channel_copy_out(noza_channel_t *ch, uint32_t pos, uint8_t *dst, uint32_t n)
+{
+    uint32_t idx = pos & (ch->capacity - 1);
+    uint32_t first = ch->capacity - idx;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(dst, ch->data + idx * ch->elem_size, first * ch->elem_size);
+    if (n > first) {
+        memcpy(dst + first * ch->elem_size, ch->data, (n - first) * ch->elem_size);
+    }
+}
+
+// claim and publish up to count slots without blocking
+static uint32_t channel_put(noza_channel_t *ch, const uint8_t *src, uint32_t count)
+{
+    uint32_t start, n;
+    if (ch->flags & NOZA_CHANNEL_MPSC) {
+        start = __atomic_load_n(&ch->reserve, __ATOMIC_RELAXED);
+        for (;;) {
+            uint32_t head = __atomic_load_n(&ch->head, __ATOMIC_ACQUIRE);
+            uint32_t space = ch->capacity - (start - head);
+            n = (count < space) ? count : space;
+            if (n == 0) {
+                return 0;
+            }
+            if (__atomic_compare_exchange_n(&ch->reserve, &start, start + n, true,
+                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+    } else {
+        start = ch->tail;
+        uint32_t head = __atomic_load_n(&ch->head, __ATOMIC_ACQUIRE);
+        uint32_t space = ch->capacity - (start - head);
+        n = (count < space) ? count : space;
+        if (n == 0) {
+            return 0;
+        }
+    }
+
+    channel_copy_in(ch, start, src, n);
+
+    if (ch->flags & NOZA_CHANNEL_MPSC) {
+        // publish in claim order: an earlier producer still copying holds the tail back.
+        // Sleep on tail instead of yielding, the earlier producer may run at a lower priority
+        for (;;) {
+            uint32_t tail = __atomic_load_n(&ch->tail, __ATOMIC_SEQ_CST);
+            if (tail == start) {
+                break;
+            }
+            __atomic_add_fetch(&ch->publishers_waiting, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&ch->tail, __ATOMIC_SEQ_CST) == tail) {
+                noza_futex_wait((uint32_t *)&ch->tail, tail, -1);
+            }
+            __atomic_sub_fetch(&ch->publishers_waiting, 1, __ATOMIC_SEQ_CST);
+        }
+    }
+    __atomic_store_n(&ch->tail, start + n, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ch->publishers_waiting, __ATOMIC_SEQ_CST)) {
+        noza_futex_wake((uint32_t *)&ch->tail, CHANNEL_WAKE_ALL); // the consumer and every parked producer
+    } else if (__atomic_load_n(&ch->consumer_waiting, __ATOMIC_SEQ_CST)) {
+        noza_futex_wake((uint32_t *)&ch->tail, 1);
+    }
+    return n;
+}
+
+static uint32_t channel_take(noza_channel_t *ch, uint8_t *dst, uint32_t max)
+{
+    uint32_t head = ch->head;
+    uint32_t avail = __atomic_load_n(&ch->tail, __ATOMIC_ACQUIRE) - head;
+    uint32_t n = (max < avail) ? max : avail;
+    if (n == 0) {
+        return 0;
+    }
+
+    channel_copy_out(ch, head, dst, n);
+
+    __atomic_store_n(&ch->head, head + n, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ch->producers_waiting, __ATOMIC_SEQ_CST)) {
+        noza_futex_wake((uint32_t *)&ch->head, CHANNEL_WAKE_ALL);
+    }
+    return n;
+}
+
+int noza_channel_init(noza_channel_t *ch, void *buffer, uint32_t elem_size, uint32_t capacity, uint32_t flags)
+{
+    if (ch == NULL || buffer == NULL || elem_size == 0 || capacity == 0 ||
+        (capacity & (capacity - 1)) != 0 || (flags & ~NOZA_CHANNEL_MPSC) != 0) {
+        return EINVAL;
+    }
+    ch->flags = flags;
+    ch->elem_size = elem_size;
+    ch->capacity = capacity;
+    ch->head = 0;
+    ch->tail = 0;
+    ch->reserve = 0;
+    ch->consumer_waiting = 0;
+    ch->producers_waiting = 0;
+    ch->publishers_waiting = 0;
+    ch->data = (uint8_t *)buffer;
+    __atomic_store_n(&ch->magic, NOZA_CHANNEL_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int noza_channel_publish(noza_channel_t *ch, const char *name, uint32_t *service_id)
+{
+    if (ch == NULL || ch->magic != NOZA_CHANNEL_MAGIC) {
+        return EINVAL;
+    }
+    return name_lookup_register_channel(name, ch, service_id);
+}
+
+int noza_channel_open(const char *name, noza_channel_t **ch)
+{
+    void *addr = NULL;
+    int ret = name_lookup_resolve_channel(name, &addr);
+    if (ret != NAME_LOOKUP_OK) {
+        return ret;
+    }
+    noza_channel_t *found = (noza_channel_t *)addr;
+    if (__atomic_load_n(&found->magic, __ATOMIC_ACQUIRE) != NOZA_CHANNEL_MAGIC) {
+        return EINVAL;
+    }
+    if (ch) {
+        *ch = found;
+    }
+    return 0;
+}
+
+uint32_t noza_channel_send(noza_channel_t *ch, const void *elems, uint32_t count, int32_t timeout_us)
+{
+    const uint8_t *src = (const uint8_t *)elems;
+    int64_t deadline_us = (timeout_us > 0) ? channel_now_us() + timeout_us : 0;
+    uint32_t sent = 0;
+
+    while (sent < count) {
+        uint32_t n = channel_put(ch, src + sent * ch->elem_size, count - sent);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+
+        int32_t wait_us = channel_remaining(timeout_us, deadline_us);
+        if (wait_us == 0) {
+            break;
+        }
+        // full: announce the sleeper before re-reading head so the consumer cannot miss it
+        uint32_t observed = __atomic_load_n(&ch->head, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&ch->producers_waiting, 1, __ATOMIC_SEQ_CST);
+        uint32_t claimed = (ch->flags & NOZA_CHANNEL_MPSC) ? ch->reserve : ch->tail;
+        int ret = 0;
+        if (__atomic_load_n(&ch->head, __ATOMIC_SEQ_CST) == observed &&
+            claimed - observed >= ch->capacity) {
+            ret = noza_futex_wait((uint32_t *)&ch->head, observed, wait_us);
+        }
+        __atomic_sub_fetch(&ch->producers_waiting, 1, __ATOMIC_SEQ_CST);
+        if (ret == ETIMEDOUT) {
+            break;
+        }
+    }
+    return sent;
+}
+
+uint32_t noza_channel_recv(noza_channel_t *ch, void *elems, uint32_t max, int32_t timeout_us)
+{
+    int64_t deadline_us = (timeout_us > 0) ? channel_now_us() + timeout_us : 0;
+    if (max == 0) {
+        return 0;
+    }
+
+    for (;;) {
+        uint32_t n = channel_take(ch, (uint8_t *)elems, max);
+        if (n > 0) {
+            return n;
+        }
+
+        int32_t wait_us = channel_remaining(timeout_us, deadline_us);
+        if (wait_us == 0) {
+            return 0;
+        }
+        // empty: same announce-then-recheck handshake against the producers' tail update
+        uint32_t observed = __atomic_load_n(&ch->tail, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&ch->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+        int ret = 0;
+        if (__atomic_load_n(&ch->tail, __ATOMIC_SEQ_CST) == ch->head) {
+            ret = noza_futex_wait((uint32_t *)&ch->tail, observed, wait_us);
+        }
+        __atomic_store_n(&ch->consumer_waiting, 0, __ATOMIC_SEQ_CST);
+        if (ret == ETIMEDOUT) {
+            return 0;
+        }
+    }
+}
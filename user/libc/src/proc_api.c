@@ -11,6 +11,8 @@
 #include "kernel/noza_config.h"
 #include "printk.h"
 
+extern void noza_thread_request_entry_stack(uint32_t words);
+
 static hashslot_t PROCESS_RECORD_HASH;
 static process_record_t *process_head = NULL;
 static process_record_t PROCESS_SLOT[NOZA_MAX_PROCESSES];
@@ -217,6 +219,7 @@ static int _noza_process_exec(main_t entry, int argc, char *argv[], char *envp[]
 	if (stack_size == 0) {
 		stack_size = NOZA_THREAD_DEFAULT_STACK_SIZE;
 	}
+	noza_thread_request_entry_stack(NOZA_OS_PROCESS_STACK_SIZE);
 	int create_ret = noza_thread_create(tid, noza_process_crt0, (void *)process, 0, stack_size);
 	if (create_ret != 0) {
 		printk("noza_process_exec: thread_create ret=%d\n", create_ret);
@@ -6,7 +6,6 @@
 #include "platform.h"
 #include "posix/errno.h"
 
-extern uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
 
 pid_t waitpid(pid_t pid, int *status, int options)
 {
@@ -23,7 +22,7 @@ pid_t waitpid(pid_t pid, int *status, int options)
     if (noza_thread_self(&self_pid) != 0 || self_pid == 0) {
         uint32_t core = platform_get_running_core();
         if (core < NOZA_OS_NUM_CORES) {
-            self_pid = NOZAOS_PID[core];
+            self_pid = noza_kdata.core[core].vid;
         }
     }
     if (self_pid == 0) {
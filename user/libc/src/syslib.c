@@ -11,7 +11,6 @@
 #include "printk.h"
 
 extern void noza_thread_request_reserved_vid(uint32_t vid);
-extern uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
 
 #define NO_AUTO_FREE_STACK	0
 #define AUTO_FREE_STACK		1
@@ -19,6 +18,9 @@ extern uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
 extern int noza_syscall(uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3);
 extern int __noza_futex_wait(uint32_t *addr, uint32_t expected, int32_t timeout_us);
 extern int __noza_futex_wake(uint32_t *addr, uint32_t count);
+extern int __noza_futex_op(noza_futex_op_t *args);
+extern int __noza_wait_any(noza_wait_source_t *sources, uint32_t count, int32_t timeout_us, int32_t *remaining_us);
+extern int __noza_clock_gettime(uint32_t clock_id, noza_time64_t *timestamp);
 
 inline static uint32_t *get_stack_ptr(uint32_t pid, uint32_t *size) {
 	thread_record_t *record = get_thread_record(pid);
@@ -126,7 +128,7 @@ static thread_record_t *noza_current_thread_record(void)
 	if (noza_thread_self(&pid) != 0 || pid == 0 || get_thread_record(pid) == NULL) {
 		uint32_t core = platform_get_running_core();
 		if (core < NOZA_OS_NUM_CORES) {
-			pid = NOZAOS_PID[core];
+			pid = noza_kdata.core[core].vid;
 		}
 	}
 	return get_thread_record(pid);
@@ -139,7 +141,7 @@ int noza_set_errno(int err) {
 		if (noza_thread_self(&pid) != 0 || pid == 0 || get_thread_record(pid) == NULL) {
 			uint32_t core = platform_get_running_core();
 			if (core < NOZA_OS_NUM_CORES) {
-				pid = NOZAOS_PID[core];
+				pid = noza_kdata.core[core].vid;
 			}
 		}
 		printk("fatal: noza_set_errno: pid %ld not found\n", pid);
@@ -156,7 +158,7 @@ int noza_errno() {
 		if (noza_thread_self(&pid) != 0 || pid == 0 || get_thread_record(pid) == NULL) {
 			uint32_t core = platform_get_running_core();
 			if (core < NOZA_OS_NUM_CORES) {
-				pid = NOZAOS_PID[core];
+				pid = noza_kdata.core[core].vid;
 			}
 		}
 		printk("fatal: noza_errno: pid %ld not found\n", pid);
@@ -169,21 +171,36 @@ int noza_get_errno() {
 	return noza_errno();
 }
 
-int noza_thread_self(uint32_t *pid) {
-	extern uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
-	uint32_t core = platform_get_running_core();
-	if (core < NOZA_OS_NUM_CORES) {
-		uint32_t current_pid = NOZAOS_PID[core];
-		if (current_pid != 0 && get_thread_record(current_pid) != NULL) {
-			*pid = current_pid;
+// the vid in the caller's kdata slot is its own as long as no switch happened on that
+// core while reading it, which the slot sequence tells
+static uint32_t kdata_self_vid(void)
+{
+	for (;;) {
+		uint32_t core = platform_get_running_core();
+		if (core >= NOZA_OS_NUM_CORES) {
 			return 0;
 		}
+		noza_kdata_core_t *slot = &noza_kdata.core[core];
+		uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		uint32_t vid = slot->vid;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if ((seq & 1) == 0 && seq == slot->seq && core == platform_get_running_core()) {
+			return vid;
+		}
+	}
+}
+
+int noza_thread_self(uint32_t *pid) {
+	uint32_t current_pid = kdata_self_vid();
+	if (current_pid != 0) {
+		*pid = current_pid;
+		return 0;
 	}
 
 	uint32_t sp;
 	asm volatile ("mov %0, sp\n" : "=r" (sp));
 	for (int core = 0; core < NOZA_OS_NUM_CORES; core++) {
-		uint32_t noza_pid = NOZAOS_PID[core];
+		uint32_t noza_pid = noza_kdata.core[core].vid;
 		thread_record_t *thread_record = get_thread_record(noza_pid);
 		if (thread_record) {
 			if ((uint32_t)thread_record->stack_ptr <= sp && sp < (uint32_t)thread_record->stack_ptr + thread_record->stack_size) {
@@ -196,6 +213,54 @@ int noza_thread_self(uint32_t *pid) {
 	return -1;
 }
 
+int noza_port_recv(uint32_t port_id, noza_msg_t *msg)
+{
+	return noza_port_reply_recv(port_id, NULL, msg);
+}
+
+int noza_clock_gettime(uint32_t clock_id, noza_time64_t *timestamp)
+{
+	if (__atomic_load_n(&noza_kdata.version, __ATOMIC_ACQUIRE) != NOZA_KDATA_VERSION) {
+		return __noza_clock_gettime(clock_id, timestamp);
+	}
+
+	// the slot of the core running the caller was rebased recently enough that the
+	// raw counter has not wrapped since
+	uint32_t core, seq, count;
+	int64_t now_us;
+	noza_kdata_core_t *slot;
+	do {
+		core = platform_get_running_core();
+		slot = &noza_kdata.core[core];
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		now_us = slot->base_us;
+		count = platform_get_clock_count() - slot->base_count;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((seq & 1) != 0 || seq != slot->seq || core != platform_get_running_core());
+	now_us += (int64_t)(((uint64_t)count * noza_kdata.clock_mult) >> noza_kdata.clock_shift);
+
+	if (clock_id == NOZA_CLOCK_REALTIME) {
+		now_us += noza_kdata.realtime_offset_us;
+	}
+	if (timestamp) {
+		int64_t value_ns = now_us * 1000;
+		timestamp->high = (uint32_t)(value_ns >> 32);
+		timestamp->low = (uint32_t)(value_ns & 0xffffffff);
+	}
+	return 0;
+}
+
+int noza_wait_any(noza_wait_source_t *sources, uint32_t count, int32_t timeout_us)
+{
+	// EAGAIN: a source of a watched kind changed, look again for the time that is left
+	int32_t remaining_us;
+	int ret;
+	while ((ret = __noza_wait_any(sources, count, timeout_us, &remaining_us)) == EAGAIN) {
+		timeout_us = remaining_us;
+	}
+	return ret;
+}
+
 int noza_futex_wait(uint32_t *addr, uint32_t expected, int32_t timeout_us)
 {
 	return __noza_futex_wait(addr, expected, timeout_us);
@@ -205,3 +270,60 @@ int noza_futex_wake(uint32_t *addr, uint32_t count)
 {
 	return __noza_futex_wake(addr, count);
 }
+
+int noza_futex_wait_bitset(uint32_t *addr, uint32_t expected, uint32_t bitset, int32_t timeout_us)
+{
+	noza_futex_op_t args = {
+		.op = NOZA_FUTEX_WAIT_BITSET, .addr = addr, .val = expected, .val3 = bitset, .timeout_us = timeout_us,
+	};
+	return __noza_futex_op(&args);
+}
+
+int noza_futex_wake_bitset(uint32_t *addr, uint32_t count, uint32_t bitset)
+{
+	noza_futex_op_t args = { .op = NOZA_FUTEX_WAKE_BITSET, .addr = addr, .val = count, .val3 = bitset };
+	return __noza_futex_op(&args);
+}
+
+int noza_futex_requeue(uint32_t *addr, uint32_t wake_count, uint32_t *addr2, uint32_t requeue_count)
+{
+	noza_futex_op_t args = {
+		.op = NOZA_FUTEX_REQUEUE, .addr = addr, .val = wake_count, .addr2 = addr2, .val2 = requeue_count,
+	};
+	return __noza_futex_op(&args);
+}
+
+int noza_futex_cmp_requeue(uint32_t *addr, uint32_t expected, uint32_t wake_count, uint32_t *addr2, uint32_t requeue_count)
+{
+	noza_futex_op_t args = {
+		.op = NOZA_FUTEX_CMP_REQUEUE, .addr = addr, .val = wake_count, .addr2 = addr2, .val2 = requeue_count,
+		.val3 = expected,
+	};
+	return __noza_futex_op(&args);
+}
+
+int noza_futex_wake_op(uint32_t *addr, uint32_t wake_count, uint32_t *addr2, uint32_t wake_count2, uint32_t op)
+{
+	noza_futex_op_t args = {
+		.op = NOZA_FUTEX_WAKE_OP, .addr = addr, .val = wake_count, .addr2 = addr2, .val2 = wake_count2, .val3 = op,
+	};
+	return __noza_futex_op(&args);
+}
+
+int noza_futex_lock_pi(uint32_t *addr, int32_t timeout_us)
+{
+	noza_futex_op_t args = { .op = NOZA_FUTEX_LOCK_PI, .addr = addr, .timeout_us = timeout_us };
+	return __noza_futex_op(&args);
+}
+
+int noza_futex_trylock_pi(uint32_t *addr)
+{
+	noza_futex_op_t args = { .op = NOZA_FUTEX_TRYLOCK_PI, .addr = addr };
+	return __noza_futex_op(&args);
+}
+
+int noza_futex_unlock_pi(uint32_t *addr)
+{
+	noza_futex_op_t args = { .op = NOZA_FUTEX_UNLOCK_PI, .addr = addr };
+	return __noza_futex_op(&args);
+}
@@ -9,15 +9,21 @@
 #include "proc_api.h"
 #include "printk.h"
 
-extern uint32_t NOZAOS_PID[NOZA_OS_NUM_CORES];
 
 static hashslot_t THREAD_RECORD_HASH;
 static uint32_t g_next_reserved_vid = NOZA_VID_AUTO;
+static uint32_t g_next_entry_stack = 0;
 
 void noza_thread_request_reserved_vid(uint32_t vid)
 {
 	g_next_reserved_vid = vid;
 }
+
+// kernel entry stack (in words) for the next created thread, 0 for the default
+void noza_thread_request_entry_stack(uint32_t words)
+{
+	g_next_entry_stack = words;
+}
 thread_record_t *get_thread_record(uint32_t tid)
 {
     return (thread_record_t *)mapping_get_value(&THREAD_RECORD_HASH, tid);
@@ -64,8 +70,8 @@ void noza_root_task()
 	uint32_t tid = 0;
 	if (noza_thread_self(&tid) != 0 || tid == 0) {
 		for (int core = 0; core < NOZA_OS_NUM_CORES; core++) {
-			if (NOZAOS_PID[core] != 0) {
-				tid = NOZAOS_PID[core];
+			if (noza_kdata.core[core].vid != 0) {
+				tid = noza_kdata.core[core].vid;
 				break;
 			}
 		}
@@ -130,7 +136,8 @@ int noza_thread_create_with_stack(uint32_t *pth, int (*entry)(void *, uint32_t t
 	info.r0 = NSC_THREAD_CREATE;
 	info.r1 = (uint32_t)app_run;
 	info.r2 = (uint32_t)thread_record;
-	info.r3 = (uint32_t)priority;
+	info.r3 = (uint32_t)priority | (g_next_entry_stack << NSC_THREAD_CREATE_STACK_SHIFT);
+	g_next_entry_stack = 0;
 	extern void noza_thread_create_primitive(create_thread_t *info);
 	noza_thread_create_primitive(&info);
 	*pth = info.r1;
@@ -135,6 +135,23 @@ static void test_thread_yield()
     }
 }
 
+static void test_thread_affinity()
+{
+    uint32_t pid;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_self(&pid));
+    TEST_ASSERT_EQUAL_INT(EINVAL, noza_thread_set_affinity(pid, 0));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_affinity(pid, 1u << (NOZA_OS_NUM_CORES - 1)));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_us(0, NULL));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_affinity(pid, NOZA_AFFINITY_ANY));
+
+    uint32_t th;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&th, yield_test_func, NULL, 1, 1024));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_affinity(th, 1));
+    uint32_t exit_code = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(th, &exit_code));
+    TEST_ASSERT_EQUAL_INT(ESRCH, noza_thread_set_affinity(th, 1));
+}
+
 static void test_noza_thread_detach()
 {
     int value[NUM_THREADS];
@@ -209,6 +226,182 @@ static void test_futex_timeout(void)
     TEST_ASSERT_EQUAL_INT(ETIMEDOUT, exit_code);
 }
 
+static void test_futex_many_addresses(void)
+{
+    // each timed-out wait drains its address entry, more addresses than entries never run out
+    static uint32_t words[256];
+    for (int i = 0; i < 256; i++) {
+        TEST_ASSERT_EQUAL_INT(ETIMEDOUT, noza_futex_wait(&words[i], 0, 100));
+        TEST_ASSERT_EQUAL_INT(0, noza_futex_wake(&words[i], 1));
+    }
+}
+
+static uint32_t futex_requeue_src;
+static uint32_t futex_requeue_dst;
+
+static int futex_requeue_worker(void *param, uint32_t pid)
+{
+    (void)param;
+    (void)pid;
+    return noza_futex_wait(&futex_requeue_src, 0, -1);
+}
+
+static void test_futex_requeue(void)
+{
+    futex_requeue_src = 0;
+    futex_requeue_dst = 0;
+    uint32_t th[2];
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&th[i], futex_requeue_worker, NULL, 1, 1024));
+    }
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(5, NULL));
+
+    // wake one, move the other onto the second word without waking it
+    TEST_ASSERT_EQUAL_INT(EAGAIN, noza_futex_cmp_requeue(&futex_requeue_src, 1, 1, &futex_requeue_dst, 1));
+    TEST_ASSERT_EQUAL_INT(2, noza_futex_cmp_requeue(&futex_requeue_src, 0, 1, &futex_requeue_dst, 1));
+    TEST_ASSERT_EQUAL_INT(0, noza_futex_wake(&futex_requeue_src, 1));
+    TEST_ASSERT_EQUAL_INT(1, noza_futex_wake(&futex_requeue_dst, 1));
+    for (int i = 0; i < 2; i++) {
+        uint32_t exit_code = 1;
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_join(th[i], &exit_code));
+        TEST_ASSERT_EQUAL_INT(0, exit_code);
+    }
+}
+
+// wakes and requeues take the most urgent waiter first, whatever the order they queued in
+#define FUTEX_ORDER_WAITERS 3
+static uint32_t futex_order_src;
+static uint32_t futex_order_dst;
+static uint32_t futex_order[FUTEX_ORDER_WAITERS];
+static uint32_t futex_order_count;
+
+static int futex_order_worker(void *param, uint32_t pid)
+{
+    (void)pid;
+    int ret = noza_futex_wait(&futex_order_src, 0, -1);
+    futex_order[futex_order_count++] = (uint32_t)(uintptr_t)param;
+    return ret;
+}
+
+static void test_futex_wake_priority_order(void)
+{
+    uint32_t th[FUTEX_ORDER_WAITERS];
+    futex_order_src = 0;
+    futex_order_dst = 0;
+    futex_order_count = 0;
+    // queue the least urgent waiter first
+    for (int i = 0; i < FUTEX_ORDER_WAITERS; i++) {
+        uint32_t prio = FUTEX_ORDER_WAITERS - i;
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&th[i], futex_order_worker, (void *)(uintptr_t)prio, prio, 1024));
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(2, NULL));
+    }
+
+    // wake the most urgent, move the other two, then drain the second word one at a time
+    TEST_ASSERT_EQUAL_INT(FUTEX_ORDER_WAITERS, noza_futex_cmp_requeue(&futex_order_src, 0, 1, &futex_order_dst, FUTEX_ORDER_WAITERS));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(5, NULL));
+    for (int i = 1; i < FUTEX_ORDER_WAITERS; i++) {
+        TEST_ASSERT_EQUAL_INT(1, noza_futex_wake(&futex_order_dst, 1));
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(5, NULL));
+    }
+    for (int i = 0; i < FUTEX_ORDER_WAITERS; i++) {
+        uint32_t exit_code = 1;
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_join(th[i], &exit_code));
+        TEST_ASSERT_EQUAL_INT(0, exit_code);
+    }
+    TEST_ASSERT_EQUAL_UINT32(FUTEX_ORDER_WAITERS, futex_order_count);
+    for (int i = 0; i < FUTEX_ORDER_WAITERS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(i + 1, futex_order[i]);
+    }
+}
+
+static int futex_bitset_worker(void *param, uint32_t pid)
+{
+    (void)pid;
+    futex_ctx_t *ctx = (futex_ctx_t *)param;
+    ctx->result = noza_futex_wait_bitset((uint32_t *)&ctx->futex_word, 0, 0x2, -1);
+    return ctx->result;
+}
+
+static void test_futex_bitset_and_wake_op(void)
+{
+    futex_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    uint32_t th;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&th, futex_bitset_worker, &ctx, 1, 1024));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(5, NULL));
+    TEST_ASSERT_EQUAL_INT(0, noza_futex_wake_bitset((uint32_t *)&ctx.futex_word, 1, 0x1));
+
+    // old value 0 == 0, so the waiter on the modified word is woken as well
+    uint32_t other = 0;
+    uint32_t op = NOZA_FUTEX_OP(NOZA_FUTEX_OP_ADD, 1, NOZA_FUTEX_OP_CMP_EQ, 0);
+    TEST_ASSERT_EQUAL_INT(1, noza_futex_wake_op(&other, 1, (uint32_t *)&ctx.futex_word, 1, op));
+    TEST_ASSERT_EQUAL_UINT32(1, ctx.futex_word);
+    uint32_t exit_code = 1;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(th, &exit_code));
+    TEST_ASSERT_EQUAL_INT(0, exit_code);
+}
+
+// wake-op's update of the second word races user-space atomics on it without losing either
+#define WAKE_OP_RACE_ROUNDS 2000
+static uint32_t wake_op_race_word;
+
+static int wake_op_race_thread(void *param, uint32_t pid)
+{
+    (void)param;
+    (void)pid;
+    for (int i = 0; i < WAKE_OP_RACE_ROUNDS; i++) {
+        __atomic_fetch_add(&wake_op_race_word, 1, __ATOMIC_SEQ_CST);
+    }
+    return 0;
+}
+
+static void test_futex_wake_op_atomic(void)
+{
+    uint32_t th, code = 1, other = 0;
+    uint32_t op = NOZA_FUTEX_OP(NOZA_FUTEX_OP_ADD, 1, NOZA_FUTEX_OP_CMP_EQ, 0);
+    wake_op_race_word = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&th, wake_op_race_thread, NULL, 0, 1024));
+    for (int i = 0; i < WAKE_OP_RACE_ROUNDS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_futex_wake_op(&other, 1, &wake_op_race_word, 1, op));
+    }
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(th, &code));
+    TEST_ASSERT_EQUAL_INT(0, code);
+    TEST_ASSERT_EQUAL_UINT32(2 * WAKE_OP_RACE_ROUNDS, wake_op_race_word);
+}
+
+static uint32_t futex_pi_word;
+
+static int futex_pi_worker(void *param, uint32_t pid)
+{
+    (void)param;
+    (void)pid;
+    int ret = noza_futex_lock_pi(&futex_pi_word, -1);
+    if (ret != 0) {
+        return ret;
+    }
+    return noza_futex_unlock_pi(&futex_pi_word);
+}
+
+static void test_futex_pi_handoff(void)
+{
+    futex_pi_word = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_futex_lock_pi(&futex_pi_word, -1));
+    TEST_ASSERT_EQUAL_INT(EDEADLK, noza_futex_lock_pi(&futex_pi_word, -1));
+
+    uint32_t th;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&th, futex_pi_worker, NULL, 1, 1024));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(5, NULL));
+    TEST_ASSERT_TRUE((futex_pi_word & NOZA_FUTEX_PI_WAITERS) != 0);
+
+    // unlock hands the lock straight to the blocked worker
+    TEST_ASSERT_EQUAL_INT(0, noza_futex_unlock_pi(&futex_pi_word));
+    uint32_t exit_code = 1;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(th, &exit_code));
+    TEST_ASSERT_EQUAL_INT(0, exit_code);
+    TEST_ASSERT_EQUAL_UINT32(0, futex_pi_word);
+    TEST_ASSERT_EQUAL_INT(EPERM, noza_futex_unlock_pi(&futex_pi_word));
+}
+
 static void test_fs_chmod_chown(void)
 {
     const char *path = "/own.txt";
@@ -328,6 +521,36 @@ static void test_timer_cancel(void)
     TEST_ASSERT_EQUAL_INT(0, noza_timer_delete(timer_id));
 }
 
+// a loose timer may wait for the precise one due after it and share its wakeup,
+// but never fires before its own deadline or past its slack
+static void test_timer_slack(void)
+{
+    uint32_t loose = 0, tight = 0, stale = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_create(&stale));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_delete(stale));
+    TEST_ASSERT_EQUAL_INT(ESRCH, noza_timer_set_slack(stale, 1000));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_create(&loose));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_create(&tight));
+
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_set_slack(0, 20000));
+    uint64_t start_ns = monotonic_ns();
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_arm(loose, 5000, NOZA_TIMER_FLAG_SLACK));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_arm(tight, 15000, 0));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_wait(loose, -1));
+    uint64_t loose_ns = monotonic_ns() - start_ns;
+    // due at 5 ms with 20 ms of slack: it rides the tight timer's 15 ms wakeup
+    TEST_ASSERT_TRUE(loose_ns >= 14000000ull && loose_ns < 25000000ull);
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_wait(tight, -1));
+    TEST_ASSERT_TRUE(monotonic_ns() - start_ns >= 14000000ull);
+
+    start_ns = monotonic_ns();
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(5, NULL)); // sleeps carry the thread's slack too
+    TEST_ASSERT_TRUE(monotonic_ns() - start_ns >= 4000000ull);
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_set_slack(0, 0));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_delete(loose));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_delete(tight));
+}
+
 static void test_clock_monotonic(void)
 {
     uint64_t start_ns = monotonic_ns();
@@ -336,6 +559,174 @@ static void test_clock_monotonic(void)
     TEST_ASSERT_TRUE(end_ns > start_ns);
 }
 
+// thread id and clock come off the kernel data page; they must agree with the kernel
+static int kdata_self_thread(void *param, uint32_t pid)
+{
+    uint32_t self = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_self(&self));
+    *(uint32_t *)param = self;
+    return self == pid ? 0 : 1;
+}
+
+static void test_kernel_data_page(void)
+{
+    uint32_t vid, code, seen = 0;
+    TEST_ASSERT_EQUAL_UINT32(NOZA_KDATA_VERSION, noza_kdata.version);
+    TEST_ASSERT_EQUAL_UINT32(NOZA_OS_NUM_CORES, noza_kdata.num_cores);
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&vid, kdata_self_thread, &seen, 0, 1024));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(vid, &code));
+    TEST_ASSERT_EQUAL_INT(0, code);
+    TEST_ASSERT_EQUAL_UINT32(vid, seen);
+
+    uint64_t last_ns = monotonic_ns();
+    for (int i = 0; i < 100; i++) {
+        uint64_t now_ns = monotonic_ns();
+        TEST_ASSERT_TRUE(now_ns >= last_ns);
+        last_ns = now_ns;
+    }
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(5, NULL));
+    TEST_ASSERT_TRUE(monotonic_ns() - last_ns >= 4000000ull);
+}
+
+// a deadline thread spinning on core 0 is throttled after its runtime in every
+// period, so a fixed-priority thread pinned to the same core still gets to run
+static volatile uint32_t edf_stop;
+
+static int edf_hog_thread(void *param, uint32_t pid)
+{
+    (void)param;
+    noza_sched_deadline_t attr = {.runtime_us = 2000, .deadline_us = 10000, .period_us = 10000};
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_affinity(pid, 1));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_deadline(0, &attr));
+    uint64_t start_ns = monotonic_ns();
+    while (!edf_stop && monotonic_ns() - start_ns < 200000000ull) {
+    }
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_deadline(0, NULL));
+    return edf_stop ? 0 : 1;
+}
+
+static void test_edf_budget(void)
+{
+    uint32_t self, hog, code;
+    noza_sched_deadline_t bad = {.runtime_us = 3000, .deadline_us = 2000, .period_us = 10000};
+    noza_sched_deadline_t greedy = {.runtime_us = 9500, .deadline_us = 10000, .period_us = 10000};
+    // 20% of the period, but all of it inside a 2 ms window
+    noza_sched_deadline_t tight = {.runtime_us = 2000, .deadline_us = 2000, .period_us = 10000};
+    noza_sched_deadline_t dense = {.runtime_us = 1500, .deadline_us = 2000, .period_us = 10000};
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_self(&self));
+    TEST_ASSERT_EQUAL_INT(EINVAL, noza_thread_set_deadline(0, &bad));
+    TEST_ASSERT_EQUAL_INT(EBUSY, noza_thread_set_deadline(0, &greedy)); // over the class share of a core
+    TEST_ASSERT_EQUAL_INT(EBUSY, noza_thread_set_deadline(0, &tight));  // density, not runtime/period
+
+    edf_stop = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_affinity(self, 1));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_us(0, NULL));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&hog, edf_hog_thread, NULL, NOZA_OS_PRIORITY_LIMIT - 1, 1024));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(30, NULL));
+    // the hog holds 20% of core 0, 75% more would pass a utilization test but not density
+    TEST_ASSERT_EQUAL_INT(EBUSY, noza_thread_set_deadline(0, &dense));
+    edf_stop = 1;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(hog, &code));
+    TEST_ASSERT_EQUAL_INT(0, code);
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_set_affinity(self, NOZA_AFFINITY_ANY));
+}
+
+static int stats_sleeper_thread(void *param, uint32_t pid)
+{
+    (void)param;
+    (void)pid;
+    for (int i = 0; i < 3; i++) {
+        noza_thread_sleep_ms(1, NULL);
+    }
+    noza_thread_sleep_ms(50, NULL); // still asleep when the snapshot is taken
+    return 0;
+}
+
+static void test_thread_stats(void)
+{
+    noza_thread_stat_t stats[8];
+    uint32_t self, th, code, count = 0;
+    uint32_t offset = 0, seen = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_self(&self));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&th, stats_sleeper_thread, NULL, 1, 1024));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(20, NULL));
+
+    do {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_stats(stats, 8, offset, &count));
+        for (uint32_t i = 0; i < count; i++) {
+            if (stats[i].vid == self) {
+                TEST_ASSERT_EQUAL_UINT(NOZA_THREAD_STATE_RUNNING, stats[i].state);
+                TEST_ASSERT_NOT_EQUAL(0, stats[i].syscalls);
+                seen |= 1;
+            } else if (stats[i].vid == th) {
+                TEST_ASSERT_EQUAL_UINT(NOZA_THREAD_STATE_SLEEP, stats[i].state);
+                TEST_ASSERT_TRUE(stats[i].syscalls >= 4);
+                TEST_ASSERT_TRUE(stats[i].voluntary_switches >= 4); // every sleep gave up the core
+                TEST_ASSERT_TRUE(stats[i].last_core < NOZA_OS_NUM_CORES);
+                seen |= 2;
+            }
+        }
+        offset += count;
+    } while (count == 8);
+    TEST_ASSERT_EQUAL_UINT(3, seen);
+
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(th, &code));
+}
+
+// the kernel lock counters are readable in every build, the sched lock is taken on every switch
+static void test_lock_stats(void)
+{
+    noza_lock_stat_t stats[16];
+    uint32_t count = 0, seen = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_sleep_ms(1, NULL));
+    TEST_ASSERT_EQUAL_INT(0, noza_lock_stats(stats, 16, &count));
+    TEST_ASSERT_TRUE(count > 4 && count < 16);
+    for (uint32_t i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(stats[i].contended <= stats[i].acquired);
+        if (strcmp(stats[i].name, "sched") == 0) {
+            TEST_ASSERT_NOT_EQUAL(0, stats[i].acquired);
+            seen |= 1;
+        } else if (strcmp(stats[i].name, "futex") == 0) {
+            seen |= 2;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(3, seen);
+    TEST_ASSERT_EQUAL_INT(0, noza_lock_stats(stats, 2, &count));
+    TEST_ASSERT_EQUAL_UINT(2, count);
+}
+
+static void test_trace_ring(void)
+{
+    noza_trace_record_t recs[16];
+    uint32_t count = 0;
+#if NOZA_OS_ENABLE_TRACE
+    static uint32_t trace_word;
+    uint32_t self, was_on;
+    int seen = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_self(&self));
+    TEST_ASSERT_EQUAL_INT(0, noza_trace_enable(1, &was_on));
+    do {
+        TEST_ASSERT_EQUAL_INT(0, noza_trace_read(recs, 16, &count)); // drop what earlier tests left
+    } while (count == 16);
+
+    TEST_ASSERT_EQUAL_INT(0, noza_futex_wake(&trace_word, 1));
+    do {
+        TEST_ASSERT_EQUAL_INT(0, noza_trace_read(recs, 16, &count));
+        for (uint32_t i = 0; i < count; i++) {
+            TEST_ASSERT_TRUE(recs[i].core < NOZA_OS_NUM_CORES);
+            if (recs[i].event == NOZA_TRACE_SYSCALL_ENTER && recs[i].vid == self &&
+                recs[i].arg == (uint32_t)&trace_word) {
+                seen = 1;
+            }
+        }
+    } while (count == 16);
+    TEST_ASSERT_TRUE(seen);
+    TEST_ASSERT_EQUAL_INT(0, noza_trace_enable(was_on, NULL));
+#else
+    TEST_ASSERT_EQUAL_INT(ENOSYS, noza_trace_read(recs, 16, &count));
+#endif
+}
+
 typedef struct {
     volatile uint32_t futex_word;
     uint32_t pending_mask;
@@ -436,6 +827,438 @@ static void test_noza_message()
     TEST_ASSERT_EQUAL_INT(SERVER_EXIT_CODE, code);
 }
 
+static int echo_server_thread(void *param, uint32_t pid)
+{
+    (void)param;
+    (void)pid;
+    noza_msg_t msg;
+    noza_msg_t *reply = NULL;
+    for (;;) {
+        TEST_ASSERT_EQUAL_INT(0, noza_reply_recv(reply, &msg));
+        echo_msg_t *echo = (echo_msg_t *)msg.ptr;
+        if (echo->cmd == ECHO_END) {
+            noza_reply(&msg);
+            break;
+        }
+        echo->value++;
+        reply = &msg;
+    }
+    return SERVER_EXIT_CODE;
+}
+
+static void test_noza_reply_recv()
+{
+    uint32_t code, server_vid;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&server_vid, echo_server_thread, NULL, 0, 1024));
+    echo_msg_t echo = { .cmd = ECHO_INC, .value = 0 };
+    noza_msg_t msg;
+    for (uint32_t i = 0; i < 10; i++) {
+        msg.to_vid = server_vid;
+        msg.ptr = &echo;
+        msg.size = sizeof(echo);
+        TEST_ASSERT_EQUAL_INT(0, noza_call(&msg));
+        TEST_ASSERT_EQUAL_UINT32(i + 1, echo.value);
+    }
+    echo.cmd = ECHO_END;
+    msg.to_vid = server_vid;
+    msg.ptr = &echo;
+    msg.size = sizeof(echo);
+    TEST_ASSERT_EQUAL_INT(0, noza_call(&msg));
+    noza_thread_join(server_vid, &code);
+    TEST_ASSERT_EQUAL_INT(SERVER_EXIT_CODE, code);
+}
+
+// short messages: the words travel in registers and the server never sees a client pointer
+static int short_echo_server_thread(void *param, uint32_t pid)
+{
+    (void)param;
+    (void)pid;
+    noza_msg_t msg;
+    noza_msg_t *reply = NULL;
+    for (;;) {
+        TEST_ASSERT_EQUAL_INT(0, noza_reply_recv(reply, &msg));
+        TEST_ASSERT_EQUAL_UINT32(NOZA_MSG_SHORT, msg.size);
+        TEST_ASSERT_NULL(msg.ptr);
+        if (msg.word[0] == ECHO_END) {
+            noza_reply(&msg);
+            break;
+        }
+        for (int i = 1; i < NOZA_MSG_SHORT_WORDS; i++) {
+            msg.word[i]++;
+        }
+        reply = &msg;
+    }
+    return SERVER_EXIT_CODE;
+}
+
+static void test_noza_short_message()
+{
+    uint32_t code, server_vid;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&server_vid, short_echo_server_thread, NULL, 0, 1024));
+    noza_msg_t msg = {.to_vid = server_vid, .size = NOZA_MSG_SHORT, .word = {ECHO_INC, 10, 20, 30}};
+    for (uint32_t i = 0; i < 10; i++) {
+        msg.to_vid = server_vid;
+        msg.size = NOZA_MSG_SHORT;
+        TEST_ASSERT_EQUAL_INT(0, noza_call(&msg));
+        TEST_ASSERT_EQUAL_UINT32(NOZA_MSG_SHORT, msg.size);
+        TEST_ASSERT_EQUAL_UINT32(ECHO_INC, msg.word[0]);
+        TEST_ASSERT_EQUAL_UINT32(11 + i, msg.word[1]);
+        TEST_ASSERT_EQUAL_UINT32(21 + i, msg.word[2]);
+        TEST_ASSERT_EQUAL_UINT32(31 + i, msg.word[3]);
+    }
+    msg.to_vid = server_vid;
+    msg.size = NOZA_MSG_SHORT;
+    msg.word[0] = ECHO_END;
+    TEST_ASSERT_EQUAL_INT(0, noza_call(&msg));
+    noza_thread_join(server_vid, &code);
+    TEST_ASSERT_EQUAL_INT(SERVER_EXIT_CODE, code);
+}
+
+// callers queued on a port are served most urgent first, with or without donation
+#define PENDING_CLIENTS 3
+static uint32_t pending_server_vid;
+static uint32_t pending_order[PENDING_CLIENTS];
+
+// the priority a thread currently runs at, as reported by noza_thread_stats
+static uint32_t pending_running_priority(uint32_t vid)
+{
+    noza_thread_stat_t stats[8];
+    uint32_t offset = 0, count = 0;
+    do {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_stats(stats, 8, offset, &count));
+        for (uint32_t i = 0; i < count; i++) {
+            if (stats[i].vid == vid) {
+                return stats[i].priority;
+            }
+        }
+        offset += count;
+    } while (count == 8);
+    TEST_FAIL_MESSAGE("thread missing from the stats snapshot");
+    return 0;
+}
+
+static int pending_server_thread(void *param, uint32_t pid)
+{
+    noza_msg_t msg;
+    uint32_t flags = (uint32_t)(uintptr_t)param;
+    TEST_ASSERT_EQUAL_INT(EINVAL, noza_port_set_flags(0x80));
+    TEST_ASSERT_EQUAL_INT(0, noza_port_set_flags(flags));
+    noza_thread_sleep_ms(50, NULL); // let every client queue up
+    for (int i = 0; i < PENDING_CLIENTS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_recv(&msg));
+        pending_order[i] = msg.word[0];
+        // the caller being served is the most urgent one left, a donating server runs at its priority
+        uint32_t expected = (flags & NOZA_PORT_PRIORITY_DONATION) ? msg.word[0] : NOZA_OS_PRIORITY_LIMIT - 1;
+        TEST_ASSERT_EQUAL_UINT32(expected, pending_running_priority(pid));
+        noza_reply(&msg);
+    }
+    return SERVER_EXIT_CODE;
+}
+
+static int pending_client_thread(void *param, uint32_t pid)
+{
+    (void)pid;
+    noza_msg_t msg = {.to_vid = pending_server_vid, .size = NOZA_MSG_SHORT,
+        .word = {(uint32_t)(uintptr_t)param}};
+    return noza_call(&msg);
+}
+
+static void test_noza_pending_priority()
+{
+    for (uint32_t flags = 0; flags <= NOZA_PORT_PRIORITY_DONATION; flags++) {
+        uint32_t code, client_vid[PENDING_CLIENTS];
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&pending_server_vid, pending_server_thread,
+            (void *)(uintptr_t)flags, NOZA_OS_PRIORITY_LIMIT - 1, 1024));
+        // queued least urgent first, the priority is also the payload
+        for (int i = 0; i < PENDING_CLIENTS; i++) {
+            uint32_t priority = PENDING_CLIENTS - i;
+            TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&client_vid[i], pending_client_thread,
+                (void *)(uintptr_t)priority, priority, 1024));
+        }
+        for (int i = 0; i < PENDING_CLIENTS; i++) {
+            TEST_ASSERT_EQUAL_INT(0, noza_thread_join(client_vid[i], &code));
+            TEST_ASSERT_EQUAL_INT(0, code);
+        }
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_join(pending_server_vid, &code));
+        TEST_ASSERT_EQUAL_INT(SERVER_EXIT_CODE, code);
+        for (int i = 0; i < PENDING_CLIENTS; i++) {
+            TEST_ASSERT_EQUAL_UINT32(i + 1, pending_order[i]);
+        }
+    }
+}
+
+// a port object shared by two workers, callers address the port instead of a thread
+#define PORT_WORKERS 2
+static uint32_t test_port_id;
+
+static int port_worker_thread(void *param, uint32_t pid)
+{
+    (void)pid;
+    noza_msg_t msg;
+    noza_msg_t *reply = NULL;
+    for (;;) {
+        TEST_ASSERT_EQUAL_INT(0, noza_port_reply_recv(test_port_id, reply, &msg));
+        if (msg.word[0] == ECHO_END) {
+            noza_reply(&msg);
+            break;
+        }
+        msg.word[1]++;
+        msg.word[2] = (uint32_t)(uintptr_t)param;
+        reply = &msg;
+    }
+    return SERVER_EXIT_CODE;
+}
+
+static void test_noza_port_workers()
+{
+    uint32_t code, worker_vid[PORT_WORKERS];
+    TEST_ASSERT_EQUAL_INT(0, noza_port_create(&test_port_id));
+    TEST_ASSERT_TRUE(NOZA_PORT_IS_ID(test_port_id));
+    for (int i = 0; i < PORT_WORKERS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&worker_vid[i], port_worker_thread,
+            (void *)(uintptr_t)i, 0, 1024));
+    }
+    noza_msg_t msg;
+    for (uint32_t i = 0; i < 10; i++) {
+        msg.to_vid = test_port_id;
+        msg.size = NOZA_MSG_SHORT;
+        msg.word[0] = ECHO_INC;
+        msg.word[1] = i;
+        msg.word[2] = PORT_WORKERS;
+        TEST_ASSERT_EQUAL_INT(0, noza_call(&msg));
+        TEST_ASSERT_EQUAL_UINT32(i + 1, msg.word[1]);
+        TEST_ASSERT_LESS_THAN_UINT32(PORT_WORKERS, msg.word[2]);
+    }
+    // one END per worker, each stops after answering it
+    for (int i = 0; i < PORT_WORKERS; i++) {
+        msg.to_vid = test_port_id;
+        msg.size = NOZA_MSG_SHORT;
+        msg.word[0] = ECHO_END;
+        TEST_ASSERT_EQUAL_INT(0, noza_call(&msg));
+    }
+    for (int i = 0; i < PORT_WORKERS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_join(worker_vid[i], &code));
+        TEST_ASSERT_EQUAL_INT(SERVER_EXIT_CODE, code);
+    }
+    TEST_ASSERT_EQUAL_INT(0, noza_port_destroy(test_port_id));
+    msg.to_vid = test_port_id;
+    msg.size = NOZA_MSG_SHORT;
+    TEST_ASSERT_EQUAL_INT(ESRCH, noza_call(&msg)); // a stale port id no longer resolves
+}
+
+// one trap sends to two servers; an unreachable target fails alone
+#define BATCH_SERVERS 2
+static void test_noza_call_batch()
+{
+    uint32_t code, stale_port, server_vid[BATCH_SERVERS];
+    noza_msg_t msgs[BATCH_SERVERS + 1];
+    int32_t status[BATCH_SERVERS + 1];
+    TEST_ASSERT_EQUAL_INT(0, noza_port_create(&stale_port));
+    TEST_ASSERT_EQUAL_INT(0, noza_port_destroy(stale_port));
+    for (int i = 0; i < BATCH_SERVERS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&server_vid[i], short_echo_server_thread, NULL, 0, 1024));
+    }
+    TEST_ASSERT_EQUAL_INT(EINVAL, noza_call_batch(msgs, status, 0));
+    for (int i = 0; i < BATCH_SERVERS; i++) {
+        msgs[i] = (noza_msg_t){.to_vid = server_vid[i], .size = NOZA_MSG_SHORT, .word = {ECHO_INC, i, 10 * i, 0}};
+    }
+    msgs[BATCH_SERVERS] = (noza_msg_t){.to_vid = stale_port, .size = NOZA_MSG_SHORT};
+    TEST_ASSERT_EQUAL_INT(ESRCH, noza_call_batch(msgs, status, BATCH_SERVERS + 1));
+    for (int i = 0; i < BATCH_SERVERS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, status[i]);
+        TEST_ASSERT_EQUAL_UINT32(NOZA_MSG_SHORT, msgs[i].size);
+        TEST_ASSERT_EQUAL_UINT32(i + 1, msgs[i].word[1]);
+        TEST_ASSERT_EQUAL_UINT32(10 * i + 1, msgs[i].word[2]);
+    }
+    TEST_ASSERT_EQUAL_INT(ESRCH, status[BATCH_SERVERS]);
+
+    for (int i = 0; i < BATCH_SERVERS; i++) {
+        msgs[i] = (noza_msg_t){.to_vid = server_vid[i], .size = NOZA_MSG_SHORT, .word = {ECHO_END}};
+    }
+    TEST_ASSERT_EQUAL_INT(0, noza_call_batch(msgs, status, BATCH_SERVERS));
+    for (int i = 0; i < BATCH_SERVERS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_join(server_vid[i], &code));
+        TEST_ASSERT_EQUAL_INT(SERVER_EXIT_CODE, code);
+    }
+}
+
+// requests in flight to two servers at once, each completion comes back under its tag
+#define ASYNC_SERVERS   2
+#define ASYNC_REQUESTS  4
+#define ASYNC_TAG       100
+static void test_noza_call_async()
+{
+    uint32_t code, seen = 0, server_vid[ASYNC_SERVERS];
+    noza_async_result_t result;
+    for (int i = 0; i < ASYNC_SERVERS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&server_vid[i], short_echo_server_thread, NULL, 0, 1024));
+    }
+    TEST_ASSERT_EQUAL_INT(ENOMSG, noza_async_wait(&result, 0)); // nothing in flight
+    for (uint32_t i = 0; i < ASYNC_REQUESTS; i++) {
+        noza_msg_t msg = {.to_vid = server_vid[i % ASYNC_SERVERS], .size = NOZA_MSG_SHORT, .word = {ECHO_INC, i}};
+        TEST_ASSERT_EQUAL_INT(0, noza_call_async(&msg, ASYNC_TAG + i));
+    }
+    for (uint32_t n = 0; n < ASYNC_REQUESTS; n++) {
+        TEST_ASSERT_EQUAL_INT(0, noza_async_wait(&result, -1));
+        TEST_ASSERT_EQUAL_INT(0, result.status);
+        uint32_t i = result.tag - ASYNC_TAG;
+        TEST_ASSERT_LESS_THAN_UINT32(ASYNC_REQUESTS, i);
+        TEST_ASSERT_EQUAL_UINT32(server_vid[i % ASYNC_SERVERS], result.reply.to_vid);
+        TEST_ASSERT_EQUAL_UINT32(NOZA_MSG_SHORT, result.reply.size);
+        TEST_ASSERT_EQUAL_UINT32(i + 1, result.reply.word[1]);
+        seen |= 1u << i;
+    }
+    TEST_ASSERT_EQUAL_UINT32((1u << ASYNC_REQUESTS) - 1, seen);
+    TEST_ASSERT_EQUAL_INT(ENOMSG, noza_async_wait(&result, 0));
+
+    for (int i = 0; i < ASYNC_SERVERS; i++) {
+        noza_msg_t msg = {.to_vid = server_vid[i], .size = NOZA_MSG_SHORT, .word = {ECHO_END}};
+        TEST_ASSERT_EQUAL_INT(0, noza_call(&msg));
+        TEST_ASSERT_EQUAL_INT(0, noza_thread_join(server_vid[i], &code));
+        TEST_ASSERT_EQUAL_INT(SERVER_EXIT_CODE, code);
+    }
+}
+
+// one wait over the own port, a timer and a futex word, each source wakes it in turn
+static uint32_t wait_any_word;
+static uint32_t wait_any_vid;
+static uint32_t wait_any_timer;
+
+static int wait_any_poke_thread(void *param, uint32_t pid)
+{
+    (void)param;
+    (void)pid;
+    noza_wait_source_t foreign = { .type = NOZA_WAIT_TIMER, .id = wait_any_timer };
+    TEST_ASSERT_EQUAL_INT(EPERM, noza_wait_any(&foreign, 1, 0)); // someone else's timer
+    noza_thread_sleep_ms(10, NULL);
+    wait_any_word = 1;
+    noza_futex_wake(&wait_any_word, 1);
+    noza_thread_sleep_ms(50, NULL); // after the timer
+    noza_msg_t msg = {.to_vid = wait_any_vid, .size = NOZA_MSG_SHORT};
+    return noza_call(&msg);
+}
+
+static void test_noza_wait_any()
+{
+    uint32_t code, timer_id, poke_vid;
+    noza_msg_t msg;
+    wait_any_word = 0;
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_self(&wait_any_vid));
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_create(&timer_id));
+    wait_any_timer = timer_id;
+    noza_wait_source_t sources[] = {
+        { .type = NOZA_WAIT_PORT },
+        { .type = NOZA_WAIT_TIMER, .id = timer_id },
+        { .type = NOZA_WAIT_FUTEX, .addr = &wait_any_word, .val = 0 },
+    };
+    TEST_ASSERT_EQUAL_INT(ETIMEDOUT, noza_wait_any(sources, 3, 0));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&poke_vid, wait_any_poke_thread, NULL, 0, 1024));
+
+    TEST_ASSERT_EQUAL_INT(0, noza_wait_any(sources, 3, -1));
+    TEST_ASSERT_FALSE(sources[0].ready);
+    TEST_ASSERT_FALSE(sources[1].ready);
+    TEST_ASSERT_TRUE(sources[2].ready);
+
+    sources[2].val = 1;
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_arm(timer_id, 20000, 0));
+    TEST_ASSERT_EQUAL_INT(0, noza_wait_any(sources, 3, -1));
+    TEST_ASSERT_FALSE(sources[0].ready);
+    TEST_ASSERT_TRUE(sources[1].ready);
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_wait(timer_id, 0)); // take the fire
+
+    TEST_ASSERT_EQUAL_INT(0, noza_wait_any(sources, 3, -1));
+    TEST_ASSERT_TRUE(sources[0].ready);
+    TEST_ASSERT_FALSE(sources[1].ready);
+    TEST_ASSERT_EQUAL_INT(0, noza_recv(&msg));
+    TEST_ASSERT_EQUAL_UINT32(poke_vid, msg.to_vid);
+    TEST_ASSERT_EQUAL_INT(0, noza_reply(&msg));
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(poke_vid, &code));
+    TEST_ASSERT_EQUAL_INT(0, code);
+    TEST_ASSERT_EQUAL_INT(0, noza_timer_delete(timer_id));
+}
+
+// producers find the ring by name and stream through it in batches smaller than the ring
+#include "channel.h"
+#define CHANNEL_SLOTS       8
+#define CHANNEL_ITEMS       200
+#define CHANNEL_PRODUCERS   2
+#define CHANNEL_BATCH       3
+static uint32_t channel_buffer[CHANNEL_SLOTS];
+
+static int channel_producer_thread(void *param, uint32_t pid)
+{
+    (void)pid;
+    uint32_t id = (uint32_t)(uintptr_t)param;
+    noza_channel_t *ch;
+    TEST_ASSERT_EQUAL_INT(0, noza_channel_open(id == 0 ? "chan_spsc" : "chan_mpsc", &ch));
+    uint32_t batch[CHANNEL_BATCH];
+    for (uint32_t seq = 0; seq < CHANNEL_ITEMS; seq += CHANNEL_BATCH) {
+        uint32_t n = (CHANNEL_ITEMS - seq < CHANNEL_BATCH) ? CHANNEL_ITEMS - seq : CHANNEL_BATCH;
+        for (uint32_t i = 0; i < n; i++) {
+            batch[i] = (id << 16) | (seq + i);
+        }
+        TEST_ASSERT_EQUAL_UINT32(n, noza_channel_send(ch, batch, n, -1));
+    }
+    return 0;
+}
+
+static void channel_consume(noza_channel_t *ch, uint32_t first_id, uint32_t producers)
+{
+    uint32_t next[CHANNEL_PRODUCERS + 1] = {0};
+    uint32_t batch[CHANNEL_SLOTS];
+    uint32_t total = 0;
+    while (total < producers * CHANNEL_ITEMS) {
+        uint32_t n = noza_channel_recv(ch, batch, CHANNEL_SLOTS, -1);
+        TEST_ASSERT_TRUE(n > 0 && n <= CHANNEL_SLOTS);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t id = batch[i] >> 16;
+            TEST_ASSERT_TRUE(id >= first_id && id < first_id + producers);
+            TEST_ASSERT_EQUAL_UINT32(next[id]++, batch[i] & 0xFFFF);
+        }
+        total += n;
+    }
+}
+
+static void test_noza_channel()
+{
+    noza_channel_t spsc, mpsc, *opened;
+    uint32_t spsc_id = 0, mpsc_id = 0, code, vid[CHANNEL_PRODUCERS + 1];
+    uint32_t value = 7;
+
+    TEST_ASSERT_EQUAL_INT(EINVAL, noza_channel_init(&spsc, channel_buffer, sizeof(uint32_t), 6, NOZA_CHANNEL_SPSC));
+    TEST_ASSERT_EQUAL_INT(0, noza_channel_init(&spsc, channel_buffer, sizeof(uint32_t), CHANNEL_SLOTS, NOZA_CHANNEL_SPSC));
+    TEST_ASSERT_EQUAL_UINT32(0, noza_channel_recv(&spsc, &value, 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, noza_channel_recv(&spsc, &value, 1, 1000));
+    TEST_ASSERT_EQUAL_INT(0, noza_channel_publish(&spsc, "chan_spsc", &spsc_id));
+    TEST_ASSERT_EQUAL_INT(NAME_LOOKUP_ERR_NOT_FOUND, name_lookup_resolve("chan_spsc", NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(0, noza_channel_open("chan_spsc", &opened));
+    TEST_ASSERT_EQUAL_PTR(&spsc, opened);
+
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&vid[0], channel_producer_thread, (void *)0, 0, 1024));
+    channel_consume(&spsc, 0, 1);
+    TEST_ASSERT_EQUAL_INT(0, noza_thread_join(vid[0], &code));
+    TEST_ASSERT_EQUAL_INT(0, code);
+    TEST_ASSERT_EQUAL_INT(NAME_LOOKUP_OK, name_lookup_unregister(spsc_id));
+
+    TEST_ASSERT_EQUAL_INT(0, noza_channel_init(&mpsc, channel_buffer, sizeof(uint32_t), CHANNEL_SLOTS, NOZA_CHANNEL_MPSC));
+    TEST_ASSERT_EQUAL_INT(0, noza_channel_publish(&mpsc, "chan_mpsc", &mpsc_id));
+    // second round: a higher-priority producer must not spin behind a preempted lower one
+    for (uint32_t round = 0; round < 2; round++) {
+        for (uint32_t i = 1; i <= CHANNEL_PRODUCERS; i++) {
+            uint32_t priority = round ? (i - 1) * 3 : 0;
+            TEST_ASSERT_EQUAL_INT(0, noza_thread_create(&vid[i], channel_producer_thread, (void *)(uintptr_t)i, priority, 1024));
+        }
+        channel_consume(&mpsc, 1, CHANNEL_PRODUCERS);
+        for (uint32_t i = 1; i <= CHANNEL_PRODUCERS; i++) {
+            TEST_ASSERT_EQUAL_INT(0, noza_thread_join(vid[i], &code));
+            TEST_ASSERT_EQUAL_INT(0, code);
+        }
+    }
+    uint32_t fill[CHANNEL_SLOTS + 1] = {0};
+    TEST_ASSERT_EQUAL_UINT32(CHANNEL_SLOTS, noza_channel_send(&mpsc, fill, CHANNEL_SLOTS + 1, 0));
+    TEST_ASSERT_EQUAL_INT(NAME_LOOKUP_OK, name_lookup_unregister(mpsc_id));
+}
+
 // test setjmp longjmp
 #include <stdio.h>
 #include <setjmp.h>
@@ -684,14 +1507,35 @@ int noza_unittest_main(int argc, char **argv)
     RUN_TEST(test_heavy_loading_thread);
     RUN_TEST(test_noza_thread_detach);
     RUN_TEST(test_thread_yield);
+    RUN_TEST(test_thread_affinity);
     RUN_TEST(test_futex_wait_wake);
     RUN_TEST(test_futex_timeout);
+    RUN_TEST(test_futex_many_addresses);
+    RUN_TEST(test_futex_requeue);
+    RUN_TEST(test_futex_wake_priority_order);
+    RUN_TEST(test_futex_bitset_and_wake_op);
+    RUN_TEST(test_futex_wake_op_atomic);
+    RUN_TEST(test_futex_pi_handoff);
     RUN_TEST(test_timer_one_shot);
     RUN_TEST(test_timer_periodic);
     RUN_TEST(test_timer_cancel);
+    RUN_TEST(test_timer_slack);
     RUN_TEST(test_clock_monotonic);
+    RUN_TEST(test_kernel_data_page);
+    RUN_TEST(test_edf_budget);
+    RUN_TEST(test_thread_stats);
+    RUN_TEST(test_lock_stats);
+    RUN_TEST(test_trace_ring);
     RUN_TEST(test_signal_interrupts_futex);
     RUN_TEST(test_noza_message);
+    RUN_TEST(test_noza_reply_recv);
+    RUN_TEST(test_noza_short_message);
+    RUN_TEST(test_noza_pending_priority);
+    RUN_TEST(test_noza_port_workers);
+    RUN_TEST(test_noza_call_batch);
+    RUN_TEST(test_noza_call_async);
+    RUN_TEST(test_noza_wait_any);
+    RUN_TEST(test_noza_channel);
     RUN_TEST(test_noza_mutex);
     RUN_TEST(test_noza_hardfault);
     RUN_TEST(test_noza_lookup);
@@ -714,6 +1558,12 @@ int futex_test_main(int argc, char **argv)
     UNITY_BEGIN();
     RUN_TEST(test_futex_wait_wake);
     RUN_TEST(test_futex_timeout);
+    RUN_TEST(test_futex_many_addresses);
+    RUN_TEST(test_futex_requeue);
+    RUN_TEST(test_futex_wake_priority_order);
+    RUN_TEST(test_futex_bitset_and_wake_op);
+    RUN_TEST(test_futex_wake_op_atomic);
+    RUN_TEST(test_futex_pi_handoff);
     UNITY_END();
     return 0;
 }